@@ -4,15 +4,32 @@
 #include "Core/RbsInventoryComponent.h"
 
 #include "Components/CapsuleComponent.h"
+#include "Core/RbsInventoryConstraint.h"
 #include "Core/RbsInventoryItem.h"
+#include "Core/RbsItemDefinition.h"
+#include "Core/RbsItemPoolSubsystem.h"
+#include "Core/RbsLootTable.h"
+#include "Core/RbsPickupPoolSubsystem.h"
 #include "Engine/ActorChannel.h"
+#include "Engine/AssetManager.h"
+#include "Engine/NetConnection.h"
+#include "Engine/StreamableManager.h"
 #include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "Net/Core/Misc/NetConditionGroupManager.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+#include "ReubsInventorySystem.h"
+#include "TimerManager.h"
 #include "Utils/RbsPickupInterface.h"
 
 #define LOCTEXT_NAMESPACE "Inventory"
 
+DECLARE_CYCLE_STAT(TEXT("ReplicateSubobjects"), STAT_RbsInventory_ReplicateSubobjects, STATGROUP_RbsInventory);
+
 URbsInventoryComponent::URbsInventoryComponent()
+	: Items(this)
+	, ItemInstances(this)
 {
 	PrimaryComponentTick.bCanEverTick = false;
 	SetIsReplicatedByDefault(true);
@@ -26,19 +43,40 @@ void URbsInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(URbsInventoryComponent, Items);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = RBS_WITH_PUSH_MODEL;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(URbsInventoryComponent, Items, Params);
+	DOREPLIFETIME_WITH_PARAMS_FAST(URbsInventoryComponent, ItemInstances, Params);
+
+	//The owner already has every stack
+	FDoRepLifetimeParams SummaryParams;
+	SummaryParams.bIsPushBased = RBS_WITH_PUSH_MODEL;
+	SummaryParams.Condition = COND_SkipOwner;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(URbsInventoryComponent, Summary, SummaryParams);
 }
 
 bool URbsInventoryComponent::ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags)
 {
+	SCOPE_CYCLE_COUNTER(STAT_RbsInventory_ReplicateSubobjects);
+
 	bool bWroteSomething = Super::ReplicateSubobjects(Channel, Bunch, RepFlags);
 
+	//Items are replicated by the engine through the registered subobject list
+	if (IsUsingRegisteredSubObjectList())
+		return bWroteSomething;
+
+	if (!CanReceiveDetail(Channel->Connection))
+		return bWroteSomething;
+
 	//Check if the array of items needs to replicate
 	if (Channel->KeyNeedsToReplicate(0, ReplicatedItemsKey))
 	{
-		for (auto& Item : Items)
+		for (const FRbsInventoryEntry& Entry : Items.Entries)
 		{
-			if (Channel->KeyNeedsToReplicate(Item->GetUniqueID(), Item->RepKey))
+			URbsInventoryItem* Item = Entry.Item;
+			if (IsValid(Item) && Channel->KeyNeedsToReplicate(Item->GetUniqueID(), Item->RepKey))
 			{
 				bWroteSomething |= Channel->ReplicateSubobject(Item, *Bunch, *RepFlags);
 			}
@@ -48,300 +86,2366 @@ bool URbsInventoryComponent::ReplicateSubobjects(UActorChannel* Channel, FOutBun
 	return bWroteSomething;
 }
 
-/*
- * Behaviour
- */
-
-URbsInventoryItem* URbsInventoryComponent::AddItem(URbsInventoryItem* Item)
+bool URbsInventoryComponent::CanReceiveDetail(const UNetConnection* Connection) const
 {
-	if (GetOwner()->GetLocalRole() < ROLE_Authority)
-		return nullptr;
+	if (!Connection || Connection->IsReplay())
+		return true;
 
-	URbsInventoryItem* NewItem = NewObject<URbsInventoryItem>(GetOwner(), Item->GetClass());
-	NewItem->SetQuantity(Item->GetQuantity());
-	NewItem->OwningInventory = this;
-	NewItem->AddedToInventory(this);
-	Items.Add(NewItem);
-	OnReplicated_Items();
-	NewItem->MarkDirtyForReplication();
+	if (GetOwner() && GetOwner()->GetNetConnection() == Connection)
+		return true;
+
+	return DetailViewers.ContainsByPredicate([Connection](const TWeakObjectPtr<APlayerController>& Viewer)
+	{
+		return Viewer.IsValid() && Viewer->GetNetConnection() == Connection;
+	});
+}
 
-	NewItem->OnItemModified.AddDynamic(this, &ThisClass::OnItemModified_Internal);
+void URbsInventoryComponent::AddDetailViewer(APlayerController* Viewer)
+{
+	if (!IsValid(Viewer) || GetOwnerRole() < ROLE_Authority)
+		return;
 
-	return NewItem;
+	DetailViewers.RemoveAll([](const TWeakObjectPtr<APlayerController>& Other) { return !Other.IsValid(); });
+	DetailViewers.AddUnique(Viewer);
+	Viewer->IncludeInNetConditionGroup(GetDetailNetGroup());
+	GetOwner()->ForceNetUpdate();
 }
 
-FItemAddResult URbsInventoryComponent::TryAddItem(URbsInventoryItem* Item)
+void URbsInventoryComponent::RemoveDetailViewer(APlayerController* Viewer)
 {
-	return TryAddItem_Internal(Item);
+	if (!IsValid(Viewer) || GetOwnerRole() < ROLE_Authority)
+		return;
+
+	DetailViewers.Remove(Viewer);
+	if (Viewer != GetOwningController())
+	{
+		Viewer->RemoveFromNetConditionGroup(GetDetailNetGroup());
+	}
 }
 
-FItemAddResult URbsInventoryComponent::TryAddItemFromClass(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity)
+bool URbsInventoryComponent::OpenContainer(APlayerController* Viewer)
 {
-	URbsInventoryItem* Item = NewObject<URbsInventoryItem>(GetOwner(), ItemClass);
-	Item->SetQuantity(Quantity);
-	
-	return TryAddItem_Internal(Item);
+	if (!IsValid(Viewer) || GetOwnerRole() < ROLE_Authority)
+		return false;
+
+	if (IsContainerOpenBy(Viewer))
+		return true;
+
+	MaterializeLoot();
+
+	AddDetailViewer(Viewer);
+	UpdateContainerDormancy();
+
+	if (GetWorld() && !GetWorld()->GetTimerManager().IsTimerActive(ViewerCheckTimer))
+	{
+		GetWorld()->GetTimerManager().SetTimer(ViewerCheckTimer, this, &ThisClass::CheckContainerViewers, ViewerCheckInterval, true);
+	}
+
+	OnContainerOpened.Broadcast(Viewer);
+	return true;
 }
 
-FItemAddResult URbsInventoryComponent::TryAddItem_Internal(URbsInventoryItem* Item)
+void URbsInventoryComponent::CloseContainer(APlayerController* Viewer)
 {
-	if (GetOwner()->GetLocalRole() < ROLE_Authority)
-		return FItemAddResult::AddedNone(Item->GetQuantity(), LOCTEXT("InventoryCallingFunctionsFromClient", "ERROR | You're trying to add items from a client"));;
+	if (!IsContainerOpenBy(Viewer) || GetOwnerRole() < ROLE_Authority)
+		return;
 
-	const int32 AddAmount = Item->GetQuantity();
-	if (Items.Num() + 1 > GetCapacity())
-		return FItemAddResult::AddedNone(AddAmount, LOCTEXT("InventoryCapacityFullText", "Inventory Is Full"));
+	RemoveDetailViewer(Viewer);
+	UpdateContainerDormancy();
+	OnContainerClosed.Broadcast(Viewer);
+}
 
-	if (GetCurrentWeight() + Item->Weight > GetWeightCapacity())
-		return FItemAddResult::AddedNone(AddAmount, LOCTEXT("InventoryTooMuchWeightText", "Too Much Weight"));
-	
-	const int32 WeightMaxAddAmount = FMath::FloorToInt((WeightCapacity - GetCurrentWeight()) / Item->Weight);
-	int32 ActualAddAmount = FMath::Min(AddAmount, WeightMaxAddAmount);
-	if (ActualAddAmount <= 0)
-		return FItemAddResult::AddedNone(AddAmount, LOCTEXT("InventoryErrorText", "Couldn't add any item"));
-	
-	if (Item->bStackable)
+bool URbsInventoryComponent::IsContainerOpenBy(const APlayerController* Viewer) const
+{
+	return Viewer && DetailViewers.Contains(Viewer);
+}
+
+void URbsInventoryComponent::CheckContainerViewers()
+{
+	for (int32 Index = DetailViewers.Num() - 1; Index >= 0; Index--)
 	{
-		auto ExistingItems = FindItems(Item);
-		for (auto Temp : ExistingItems)
+		APlayerController* Viewer = DetailViewers[Index].Get();
+		//Listen server hosts and standalone players have no connection
+		if (IsValid(Viewer) && (Viewer->IsLocalController() || Viewer->GetNetConnection()))
+			continue;
+
+		if (IsValid(Viewer))
 		{
-			if (Temp->GetQuantity() >= Temp->MaxStackSize)
-				continue;
-    			
-			const int32 StackAddAmount = FMath::Min(ActualAddAmount, Temp->MaxStackSize - Temp->GetQuantity());
-			if (StackAddAmount <= 0)
-				continue;
-    			
-			Temp->SetQuantity(Temp->GetQuantity() + StackAddAmount);
-			Item->SetQuantity(Item->GetQuantity() - StackAddAmount);
-			ActualAddAmount -= StackAddAmount;
+			//Leaves the detail group too
+			RemoveDetailViewer(Viewer);
 		}
-	}
-    
-	if (ActualAddAmount > 0)
-	{
-		const int32 StacksToAdd = FMath::CeilToInt(float(ActualAddAmount) / float(Item->MaxStackSize));
-		for (size_t i = 0; i < StacksToAdd; i++)
+		else
 		{
-			if (ActualAddAmount <= 0)
-				break;
-    				
-			const int32 StackAddAmount = FMath::Min(ActualAddAmount, Item->MaxStackSize);
-			if (StackAddAmount <= 0)
-				continue;
-    				
-			ActualAddAmount -= StackAddAmount;
-			Item->SetQuantity(StackAddAmount);
-			AddItem(Item);
+			DetailViewers.RemoveAt(Index);
 		}
+		UpdateContainerDormancy();
+		OnContainerClosed.Broadcast(Viewer);
 	}
 
-	if (ActualAddAmount > 0)
-		return FItemAddResult::AddedSome(Item, AddAmount, ActualAddAmount, LOCTEXT("InventoryAddedSomeText", "Couldn't add all items"));
-    		
-	return FItemAddResult::AddedAll(Item, AddAmount);
+	if (DetailViewers.Num() == 0 && GetWorld())
+	{
+		GetWorld()->GetTimerManager().ClearTimer(ViewerCheckTimer);
+	}
 }
 
-bool URbsInventoryComponent::RemoveItem(URbsInventoryItem* Item)
+void URbsInventoryComponent::UpdateContainerDormancy()
 {
-	if (GetOwnerRole() < ROLE_Authority)
-		return false;
+	if (!bDormantWhenClosed || GetOwnerRole() < ROLE_Authority)
+		return;
 
-	if (!IsValid(Item))
-		return false;
+	if (DetailViewers.Num() > 0)
+	{
+		GetOwner()->SetNetDormancy(DORM_Awake);
+	}
+	else
+	{
+		//The last state goes out before the channel closes
+		GetOwner()->SetNetDormancy(DORM_DormantAll);
+	}
+}
 
-	Item->OwningInventory = nullptr;
-	Items.RemoveSingle(Item);
-	Item->MarkDirtyForReplication();
-	
-	OnReplicated_Items();
-	
-	ReplicatedItemsKey++;
-	
-	return true;
+void URbsInventoryComponent::MaterializeLoot()
+{
+	if (!HasPendingLoot() || !GetWorld() || !GetWorld()->IsGameWorld())
+		return;
+
+	//Clients only ever get the items the server created
+	bLootMaterialized = true;
+	if (GetOwnerRole() < ROLE_Authority)
+		return;
+
+	TryAddLoot(LootTable, LootSeed != 0 ? LootSeed : static_cast<int32>(GetTypeHash(GetOwner()->GetFName())));
 }
 
-int32 URbsInventoryComponent::ConsumeItem(URbsInventoryItem* Item)
+void URbsInventoryComponent::RebuildGrid()
 {
-	if (IsValid(Item))
+	if (!bUseGrid)
+		return;
+
+	if (!Grid.IsInitialized())
 	{
-		return ConsumeItem(Item, Item->Quantity);
+		Grid.Init(GridColumns, GridRows);
+	}
+
+	Grid.Reset();
+	for (const FRbsInventoryEntry& Entry : Items.Entries)
+	{
+		if (Entry.Item)
+		{
+			Grid.Fill(Entry.GridPlacement.GetRect(Entry.Item->GridWidth, Entry.Item->GridHeight));
+		}
 	}
-	
-	return 0;
 }
 
-int32 URbsInventoryComponent::ConsumeItem(URbsInventoryItem* Item, const int32 Quantity)
+bool URbsInventoryComponent::FindGridSpace(const URbsInventoryItem* Item, const FRbsInventoryGrid& InGrid, FRbsGridPlacement& OutPlacement)
 {
-	if (GetOwner()->GetLocalRole() < ROLE_Authority)
-		return 0;
+	FIntPoint Position;
+	if (InGrid.FindSpace(FIntPoint(Item->GridWidth, Item->GridHeight), Position))
+	{
+		OutPlacement = FRbsGridPlacement(Position.X, Position.Y, false);
+		return true;
+	}
 
-	if (!IsValid(Item))
-		return 0;
+	if (Item->GridWidth != Item->GridHeight && InGrid.FindSpace(FIntPoint(Item->GridHeight, Item->GridWidth), Position))
+	{
+		OutPlacement = FRbsGridPlacement(Position.X, Position.Y, true);
+		return true;
+	}
 
-	const int32 RemoveQuantity = FMath::Min(Quantity, Item->GetQuantity());
+	return false;
+}
 
-	ensure(!(Item->GetQuantity() - RemoveQuantity < 0));
+bool URbsInventoryComponent::CanAddStack(const URbsInventoryItem* Item) const
+{
+	if (CachedStackCount >= Capacity)
+		return false;
 
-	Item->SetQuantity(Item->GetQuantity() - RemoveQuantity);
+	FRbsGridPlacement GridPlacement;
+	return !bUseGrid || FindGridSpace(Item, Grid, GridPlacement);
+}
 
-	if (Item->GetQuantity() <= 0)
-	{
-		RemoveItem(Item);
-	}
-	else
+FName URbsInventoryComponent::GetDetailNetGroup() const
+{
+	return FName(TEXT("RbsInventoryDetail"), GetUniqueID());
+}
+
+APlayerController* URbsInventoryComponent::GetOwningController() const
+{
+	//Pawns are owned by their controller
+	for (AActor* Owner = GetOwner(); Owner; Owner = Owner->GetOwner())
 	{
-		ClientRefreshInventory();
+		if (APlayerController* Controller = Cast<APlayerController>(Owner))
+			return Controller;
 	}
 
-	return RemoveQuantity;
+	return nullptr;
 }
 
-void URbsInventoryComponent::UseItem(URbsInventoryItem* Item)
+void URbsInventoryComponent::IncludeOwnerInDetailGroup()
 {
 	if (GetOwnerRole() < ROLE_Authority)
-		ServerUseItem(Item);
+		return;
 
-	if (GetOwner()->GetLocalRole() >= ROLE_Authority)
+	APlayerController* OwningController = GetOwningController();
+	APlayerController* PreviousController = DetailOwner.Get();
+	if (OwningController == PreviousController)
+		return;
+
+	//The previous owner only keeps the items while it has the container open
+	if (IsValid(PreviousController) && !IsContainerOpenBy(PreviousController))
 	{
-		if (!IsValid(FindItem(Item)))
-			return;
+		PreviousController->RemoveFromNetConditionGroup(GetDetailNetGroup());
 	}
 
-	if (IsValid(Item))
+	DetailOwner = OwningController;
+	if (OwningController)
 	{
-		Item->Use(this);
+		OwningController->IncludeInNetConditionGroup(GetDetailNetGroup());
+		GetOwner()->ForceNetUpdate();
 	}
 }
 
-void URbsInventoryComponent::ServerUseItem_Implementation(URbsInventoryItem* Item)
+void URbsInventoryComponent::OnOwnerControllerChanged(APawn* Pawn, AController* OldController, AController* NewController)
 {
-	UseItem(Item);
+	IncludeOwnerInDetailGroup();
 }
 
-void URbsInventoryComponent::DropItem(URbsInventoryItem* Item, const int32 Quantity)
+void URbsInventoryComponent::RefreshSummary()
 {
-	if (!IsValid(FindItem(Item)))
+	if (GetOwnerRole() < ROLE_Authority)
 		return;
 
-	if (GetOwnerRole() < ROLE_Authority)
+	FRbsInventorySummary NewSummary;
+	NewSummary.TotalWeight = static_cast<float>(CachedWeight);
+	NewSummary.StackCount = CachedStackCount;
+
+	for (const TPair<const UClass*, FRbsItemClassBucket>& Pair : ClassBuckets)
 	{
-		ServerDropItem(Item, Quantity);
-		return;
+		if (Pair.Key->GetDefaultObject<URbsInventoryItem>()->bVisibleInSummary)
+		{
+			NewSummary.VisibleItemClasses.Add(const_cast<UClass*>(Pair.Key));
+		}
+	}
+
+	for (const TPair<const URbsItemDefinition*, int32>& Pair : DefinitionQuantities)
+	{
+		if (Pair.Key->bVisibleInSummary)
+		{
+			NewSummary.VisibleDefinitions.Add(Pair.Key);
+		}
 	}
-	
-	const int32 DroppedQuantity = ConsumeItem(Item, Quantity);
 
-	FActorSpawnParameters SpawnParams;
-	SpawnParams.Owner = GetOwner();
-	SpawnParams.bNoFail = true;
-	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+	//Map order depends on the add and remove history, sort so the same contents compare equal
+	NewSummary.VisibleItemClasses.Sort([](const TSubclassOf<URbsInventoryItem>& A, const TSubclassOf<URbsInventoryItem>& B) { return A.Get() < B.Get(); });
+	NewSummary.VisibleDefinitions.Sort([](const TObjectPtr<const URbsItemDefinition>& A, const TObjectPtr<const URbsItemDefinition>& B) { return A.Get() < B.Get(); });
 
-	FVector SpawnLocation = GetOwner()->GetActorLocation();
-	SpawnLocation.Z -= Cast<ACharacter>(GetOwner())->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
-	
-	FTransform SpawnTransform(GetOwner()->GetActorRotation(), SpawnLocation);
+	if (NewSummary == Summary)
+		return;
 
-	ensure(Item->PickupClass);
+	Summary = MoveTemp(NewSummary);
+	MARK_PROPERTY_DIRTY_FROM_NAME(URbsInventoryComponent, Summary, this);
 
-	AActor* Pickup = GetWorld()->SpawnActor<AActor>(Item->PickupClass, SpawnTransform, SpawnParams);
-	IRbsPickupInterface::Execute_SetPickupQuantity(Pickup, DroppedQuantity);
-	IRbsPickupInterface::Execute_OnDropItem(Pickup);
+	//A closed container changed, e.g. through a script, let the players around see the new summary
+	if (GetOwner()->NetDormancy > DORM_Awake)
+	{
+		GetOwner()->FlushNetDormancy();
+	}
 }
 
-void URbsInventoryComponent::ServerDropItem_Implementation(URbsInventoryItem* Item, const int32 Quantity)
+void URbsInventoryComponent::OnRegister()
 {
-	DropItem(Item, Quantity);
+	Super::OnRegister();
+
+	if (bUseGrid && !Grid.IsInitialized())
+	{
+		Grid.Init(GridColumns, GridRows);
+	}
+
+	for (URbsInventoryConstraint* Constraint : Constraints)
+	{
+		if (Constraint)
+		{
+			Constraint->ResetAggregates();
+			for (const FRbsInventoryEntry& Entry : Items.Entries)
+			{
+				if (Entry.Item && Entry.Item->OwningInventory == this)
+				{
+					Constraint->AddQuantity(Entry.Item, Entry.Item->AccountedQuantity);
+				}
+			}
+		}
+	}
 }
 
-void URbsInventoryComponent::OnItemModified_Internal()
+void URbsInventoryComponent::BeginPlay()
 {
-	OnInventoryUpdated.Broadcast();
-}
+	Super::BeginPlay();
 
-/*
- * Helpers
- */
+	//Possession changes who owns the pawn, and with it who gets the items
+	if (APawn* Pawn = Cast<APawn>(GetOwner()))
+	{
+		Pawn->ReceiveControllerChangedDelegate.AddUniqueDynamic(this, &ThisClass::OnOwnerControllerChanged);
+	}
+	IncludeOwnerInDetailGroup();
 
-bool URbsInventoryComponent::HasItem(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity) const
+	UpdateContainerDormancy();
+}
+
+void URbsInventoryComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	URbsInventoryItem* ItemToFind = FindItemByClass(ItemClass);
-	if (IsValid(ItemToFind))
+	if (APawn* Pawn = Cast<APawn>(GetOwner()))
 	{
-		return ItemToFind->GetQuantity() >= Quantity;
+		Pawn->ReceiveControllerChangedDelegate.RemoveDynamic(this, &ThisClass::OnOwnerControllerChanged);
 	}
-	return false;
+
+	//Pooled items keep their outer alive
+	if (URbsItemPoolSubsystem* ItemPool = GetWorld() ? GetWorld()->GetSubsystem<URbsItemPoolSubsystem>() : nullptr)
+	{
+		ItemPool->ReleaseOuter(GetOwner());
+	}
+
+	ReleaseThumbnails();
+
+	Super::EndPlay(EndPlayReason);
 }
 
-URbsInventoryItem* URbsInventoryComponent::FindItem(URbsInventoryItem* Item) const
+void URbsInventoryComponent::ReadyForReplication()
 {
-	return FindItemByClass(Item->GetClass());
+	Super::ReadyForReplication();
+
+	IncludeOwnerInDetailGroup();
 }
 
-TArray<URbsInventoryItem*> URbsInventoryComponent::FindItems(URbsInventoryItem* Item) const
+void URbsInventoryComponent::MarkItemsDirty()
 {
-	return FindItemsByClass(Item->GetClass());
+	MARK_PROPERTY_DIRTY_FROM_NAME(URbsInventoryComponent, Items, this);
 }
 
-URbsInventoryItem* URbsInventoryComponent::FindItemByClass(TSubclassOf<URbsInventoryItem> ItemClass) const
+void URbsInventoryComponent::MarkItemInstancesDirty()
+{
+	MARK_PROPERTY_DIRTY_FROM_NAME(URbsInventoryComponent, ItemInstances, this);
+}
+
+void URbsInventoryComponent::MarkSubobjectsDirty()
 {
-	for (auto& Item : Items)
+	//With the registered subobject list each item is tracked on its own, bumping the inventory key would re-check every item
+	if (IsUsingRegisteredSubObjectList())
+		return;
+
+	if (UpdateBatchDepth > 0)
 	{
-		if (Item->GetClass() == ItemClass)
-		{
-			return Item;
-		}
+		bPendingSubobjectsDirty = true;
+		return;
 	}
 
-	return nullptr;
+	ReplicatedItemsKey++;
+}
+
+/*
+ * Behaviour
+ */
+
+URbsInventoryItem* URbsInventoryComponent::AddItem(URbsInventoryItem* Item)
+{
+	return AddItemStack(Item->GetClass(), Item->GetQuantity());
 }
 
-TArray<URbsInventoryItem*> URbsInventoryComponent::FindItemsByClass(TSubclassOf<URbsInventoryItem> ItemClass) const
+URbsInventoryItem* URbsInventoryComponent::AddItemStack(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity)
 {
-	TArray<URbsInventoryItem*> ItemsOfClas{};
-	for (auto& Item : Items)
-	{
-		if (Item->GetClass() == ItemClass)
-		{
-			ItemsOfClas.Add(Item);
-		}
-	}
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+		return nullptr;
 
-	return ItemsOfClas;
+	URbsItemPoolSubsystem* ItemPool = bUseItemPool ? GetWorld()->GetSubsystem<URbsItemPoolSubsystem>() : nullptr;
+	URbsInventoryItem* NewItem = ItemPool ? ItemPool->AcquireItem(ItemClass, GetOwner()) : NewObject<URbsInventoryItem>(GetOwner(), ItemClass);
+	NewItem->SetQuantity(Quantity);
+	AdoptItem(NewItem);
+
+	return NewItem;
 }
 
-float URbsInventoryComponent::GetCurrentWeight() const
+void URbsInventoryComponent::AdoptItem(URbsInventoryItem* Item)
 {
-	float Weight = 0.f;
+	//Subobjects replicate with the actor that owns them
+	if (Item->GetOuter() != GetOwner())
+	{
+		Item->Rename(nullptr, GetOwner(), REN_DontCreateRedirectors | REN_NonTransactional | REN_DoNotDirty);
+	}
 
-	for (auto& Item : Items)
+	//A stack that fits nowhere still joins the inventory, just without a cell. The add paths check the grid before getting here
+	FRbsGridPlacement GridPlacement;
+	if (bUseGrid && FindGridSpace(Item, Grid, GridPlacement))
 	{
-		Weight += Item->GetStackWeight();
+		Grid.Fill(GridPlacement.GetRect(Item->GridWidth, Item->GridHeight));
 	}
 
-	return Weight;
+	const FRbsItemHandle Handle = AllocateItemHandle();
+	Items.AddEntry(Item, Handle, GridPlacement);
+	//Last in the list, so appending it to its bucket keeps the bucket sorted
+	Item->EntryOrder = Items.Entries.Last().Order;
+	MarkItemsDirty();
+	HandleEntryAdded(Item, Handle);
+	if (IsUsingRegisteredSubObjectList())
+	{
+		//Only the members of the detail group get the item
+		FNetConditionGroupManager::RegisterSubObjectInGroup(Item, GetDetailNetGroup());
+		AddReplicatedSubObject(Item, COND_NetGroup);
+	}
+	Item->AddedToInventory(this);
+	OnReplicated_Items();
+	Item->MarkDirtyForReplication();
 }
 
-void URbsInventoryComponent::SetWeightCapacity(const float NewWeightCapacity)
+FRbsItemHandle URbsInventoryComponent::AllocateItemHandle()
 {
-	WeightCapacity = NewWeightCapacity;
-	OnInventoryUpdated.Broadcast();
+	const int32 Index = FreeHandleSlots.Num() > 0 ? FreeHandleSlots.Pop(EAllowShrinking::No) : HandleSlots.AddDefaulted();
+	return FRbsItemHandle(Index, HandleSlots[Index].Generation);
 }
 
-void URbsInventoryComponent::SetCapacity(const int32 NewCapacity)
+void URbsInventoryComponent::RecycleItem(URbsInventoryItem* Item)
 {
-	Capacity = NewCapacity;
-	OnInventoryUpdated.Broadcast();
+	if (!bUseItemPool)
+		return;
+
+	if (URbsItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<URbsItemPoolSubsystem>())
+	{
+		ItemPool->ReleaseItem(Item);
+	}
 }
 
-void URbsInventoryComponent::OnReplicated_Items()
+void URbsInventoryComponent::BeginUpdateBatch()
 {
-	OnInventoryUpdated.Broadcast();
+	UpdateBatchDepth++;
 }
 
-void URbsInventoryComponent::ClientRefreshInventory_Implementation()
+void URbsInventoryComponent::EndUpdateBatch()
 {
-	OnInventoryUpdated.Broadcast();
+	if (!ensure(UpdateBatchDepth > 0))
+		return;
+
+	if (UpdateBatchDepth > 1)
+	{
+		UpdateBatchDepth--;
+		return;
+	}
+
+	//Still batching while the items notify, so whatever they trigger folds into the single broadcast below
+	while (PendingModifiedItems.Num() > 0)
+	{
+		TArray<TWeakObjectPtr<URbsInventoryItem>> ModifiedItems = MoveTemp(PendingModifiedItems);
+		for (const TWeakObjectPtr<URbsInventoryItem>& Item : ModifiedItems)
+		{
+			if (Item.IsValid())
+			{
+				Item->bPendingModifiedBroadcast = false;
+				Item->OnItemModified.Broadcast();
+			}
+		}
+	}
+
+	UpdateBatchDepth = 0;
+
+	if (bPendingSubobjectsDirty)
+	{
+		bPendingSubobjectsDirty = false;
+		MarkSubobjectsDirty();
+	}
+
+	if (bPendingInventoryUpdate)
+	{
+		bPendingInventoryUpdate = false;
+		RefreshSummary();
+		OnInventoryUpdated.Broadcast();
+	}
+}
+
+void URbsInventoryComponent::BroadcastInventoryUpdated()
+{
+	if (UpdateBatchDepth > 0)
+	{
+		bPendingInventoryUpdate = true;
+		return;
+	}
+
+	RefreshSummary();
+	OnInventoryUpdated.Broadcast();
+}
+
+bool URbsInventoryComponent::DeferItemModified(URbsInventoryItem* Item)
+{
+	if (UpdateBatchDepth <= 0)
+		return false;
+
+	if (!Item->bPendingModifiedBroadcast)
+	{
+		Item->bPendingModifiedBroadcast = true;
+		PendingModifiedItems.Add(Item);
+	}
+
+	return true;
+}
+
+void URbsInventoryComponent::BeginInventoryUpdateBatch()
+{
+	if (BlueprintBatchDepth++ == 0 && GetWorld())
+	{
+		GetWorld()->GetTimerManager().SetTimerForNextTick(this, &ThisClass::FlushBlueprintUpdateBatches);
+	}
+
+	BeginUpdateBatch();
+}
+
+void URbsInventoryComponent::EndInventoryUpdateBatch()
+{
+	if (BlueprintBatchDepth <= 0)
+		return;
+
+	BlueprintBatchDepth--;
+	EndUpdateBatch();
+}
+
+void URbsInventoryComponent::FlushBlueprintUpdateBatches()
+{
+	while (BlueprintBatchDepth > 0)
+	{
+		EndInventoryUpdateBatch();
+	}
+}
+
+void URbsInventoryComponent::PrefetchThumbnails()
+{
+	//Dedicated servers never draw an item
+	if (GetNetMode() == NM_DedicatedServer)
+		return;
+
+	//Loaded thumbnails are requested again, so releasing the previous handle below doesn't unload them
+	TArray<FSoftObjectPath> ThumbnailPaths;
+	for (const TPair<const UClass*, FRbsItemClassBucket>& Pair : ClassBuckets)
+	{
+		//Thumbnails are only set on the class defaults, every stack of a class shares them
+		const URbsInventoryItem* Defaults = Pair.Key->GetDefaultObject<URbsInventoryItem>();
+		if (!Defaults->Thumbnail && !Defaults->SoftThumbnail.IsNull())
+		{
+			ThumbnailPaths.AddUnique(Defaults->SoftThumbnail.ToSoftObjectPath());
+		}
+	}
+
+	for (const TPair<const URbsItemDefinition*, int32>& Pair : DefinitionQuantities)
+	{
+		if (!Pair.Key->Thumbnail.IsNull())
+		{
+			ThumbnailPaths.AddUnique(Pair.Key->Thumbnail.ToSoftObjectPath());
+		}
+	}
+
+	TSharedPtr<FStreamableHandle> PreviousHandle = MoveTemp(ThumbnailsHandle);
+	if (ThumbnailPaths.Num() > 0)
+	{
+		ThumbnailsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(ThumbnailPaths, FStreamableDelegate::CreateUObject(this, &ThisClass::HandleThumbnailsLoaded));
+	}
+
+	if (PreviousHandle.IsValid())
+	{
+		PreviousHandle->ReleaseHandle();
+	}
+}
+
+void URbsInventoryComponent::ReleaseThumbnails()
+{
+	if (ThumbnailsHandle.IsValid())
+	{
+		ThumbnailsHandle->ReleaseHandle();
+		ThumbnailsHandle.Reset();
+	}
+}
+
+void URbsInventoryComponent::HandleThumbnailsLoaded()
+{
+	OnThumbnailsLoaded.Broadcast();
+}
+
+FItemAddResult URbsInventoryComponent::TryAddItem(URbsInventoryItem* Item)
+{
+	return TryAddItem_Internal(Item);
+}
+
+FItemAddResult URbsInventoryComponent::TryAddItemFromClass(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity)
+{
+	return TryAddItem_Internal(ItemClass, Quantity);
+}
+
+FItemAddResult URbsInventoryComponent::TryAddItem_Internal(URbsInventoryItem* Item)
+{
+	if (!IsValid(Item))
+		return FItemAddResult::AddedNone(0, LOCTEXT("InventoryErrorText", "Couldn't add any item"));
+
+	return TryAddItem_Internal(Item->GetClass(), Item->GetQuantity());
+}
+
+FItemAddResult URbsInventoryComponent::TryAddItem_Internal(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity)
+{
+	MaterializeLoot();
+
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+		return FItemAddResult::AddedNone(Quantity, LOCTEXT("InventoryCallingFunctionsFromClient", "ERROR | You're trying to add items from a client"));;
+
+	if (!ItemClass || Quantity <= 0)
+		return FItemAddResult::AddedNone(Quantity, LOCTEXT("InventoryErrorText", "Couldn't add any item"));
+
+	//Static data is read straight from the class, only the stacks that end up in the inventory are created
+	const URbsInventoryItem* Defaults = ItemClass->GetDefaultObject<URbsInventoryItem>();
+	FText FailureText;
+	int32 ActualAddAmount = FMath::Min(Quantity, GetMaxAddable(Defaults, &FailureText));
+	if (ActualAddAmount <= 0)
+		return FItemAddResult::AddedNone(Quantity, FailureText);
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	const int32 PlannedAmount = ActualAddAmount;
+	URbsInventoryItem* LastStack = nullptr;
+	if (Defaults->bStackable)
+	{
+		ActualAddAmount -= TopUpStacks(ItemClass, ActualAddAmount, LastStack);
+	}
+
+	const int32 StackSize = Defaults->bStackable ? Defaults->MaxStackSize : 1;
+	while (ActualAddAmount > 0 && CanAddStack(Defaults))
+	{
+		const int32 StackAddAmount = FMath::Min(ActualAddAmount, StackSize);
+		LastStack = AddItemStack(ItemClass, StackAddAmount);
+		ActualAddAmount -= StackAddAmount;
+	}
+
+	return MakeAddResult(LastStack, Quantity, PlannedAmount - ActualAddAmount);
+}
+
+FItemAddResult URbsInventoryComponent::TryMoveItemIn(URbsInventoryItem* Item)
+{
+	MaterializeLoot();
+
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+		return FItemAddResult::AddedNone(IsValid(Item) ? Item->GetQuantity() : 0, LOCTEXT("InventoryCallingFunctionsFromClient", "ERROR | You're trying to add items from a client"));
+
+	if (!IsValid(Item) || Item->GetQuantity() <= 0)
+		return FItemAddResult::AddedNone(0, LOCTEXT("InventoryErrorText", "Couldn't add any item"));
+
+	if (IsValid(Item->OwningInventory))
+		return FItemAddResult::AddedNone(Item->GetQuantity(), LOCTEXT("InventoryItemAlreadyOwnedText", "Item already belongs to an inventory"));
+
+	const int32 AddAmount = Item->GetQuantity();
+	FText FailureText;
+	int32 ActualAddAmount = FMath::Min(AddAmount, GetMaxAddable(Item, &FailureText));
+	if (ActualAddAmount <= 0)
+		return FItemAddResult::AddedNone(AddAmount, FailureText);
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	URbsInventoryItem* LastStack = nullptr;
+	if (Item->bStackable)
+	{
+		const int32 ToppedUp = TopUpStacks(Item->GetClass(), ActualAddAmount, LastStack);
+		Item->SetQuantity(Item->GetQuantity() - ToppedUp);
+		ActualAddAmount -= ToppedUp;
+	}
+
+	//Whatever is left moves in as the item itself when it all fits, otherwise the part that fits is split off
+	const int32 StackSize = Item->bStackable ? Item->MaxStackSize : 1;
+	if (ActualAddAmount > 0 && ActualAddAmount == Item->GetQuantity() && ActualAddAmount <= StackSize && CanAddStack(Item))
+	{
+		AdoptItem(Item);
+		LastStack = Item;
+		ActualAddAmount = 0;
+	}
+
+	while (ActualAddAmount > 0 && CanAddStack(Item))
+	{
+		const int32 StackAddAmount = FMath::Min(ActualAddAmount, StackSize);
+		LastStack = AddItemStack(Item->GetClass(), StackAddAmount);
+		Item->SetQuantity(Item->GetQuantity() - StackAddAmount);
+		ActualAddAmount -= StackAddAmount;
+	}
+
+	const int32 AmountGiven = LastStack == Item ? AddAmount : AddAmount - Item->GetQuantity();
+	return MakeAddResult(LastStack, AddAmount, AmountGiven);
+}
+
+int32 URbsInventoryComponent::TopUpStacks(const UClass* ItemClass, const int32 Quantity, URbsInventoryItem*& OutLastStack)
+{
+	int32 ToppedUp = 0;
+	for (URbsInventoryItem* Stack : GetStacksOfClass(ItemClass))
+	{
+		if (ToppedUp >= Quantity)
+			break;
+
+		const int32 StackAddAmount = FMath::Min(Quantity - ToppedUp, Stack->MaxStackSize - Stack->GetQuantity());
+		if (StackAddAmount <= 0)
+			continue;
+
+		Stack->SetQuantity(Stack->GetQuantity() + StackAddAmount);
+		ToppedUp += StackAddAmount;
+		OutLastStack = Stack;
+	}
+
+	return ToppedUp;
+}
+
+int32 URbsInventoryComponent::GetMaxAddableByWeight(const float ItemWeight) const
+{
+	return ItemWeight > 0.f ? FMath::FloorToInt((WeightCapacity - CachedWeight) / ItemWeight) : MAX_int32;
+}
+
+int32 URbsInventoryComponent::GetMaxAddableByStacks(const URbsInventoryItem* Item) const
+{
+	const int32 StackSize = Item->bStackable ? Item->MaxStackSize : 1;
+	int32 FreeStacks = FMath::Max(Capacity - CachedStackCount, 0);
+	if (bUseGrid)
+	{
+		//Place the stacks one after the other on a copy, each one changes where the next can go
+		FRbsInventoryGrid PlannedGrid = Grid;
+		FRbsGridPlacement GridPlacement;
+		int32 FittingStacks = 0;
+		while (FittingStacks < FreeStacks && FindGridSpace(Item, PlannedGrid, GridPlacement))
+		{
+			PlannedGrid.Fill(GridPlacement.GetRect(Item->GridWidth, Item->GridHeight));
+			FittingStacks++;
+		}
+		FreeStacks = FittingStacks;
+	}
+
+	int64 Room = int64(FreeStacks) * StackSize;
+	if (Item->bStackable)
+	{
+		for (const URbsInventoryItem* Stack : GetStacksOfClass(Item->GetClass()))
+		{
+			Room += FMath::Max(Stack->MaxStackSize - Stack->GetQuantity(), 0);
+		}
+	}
+
+	return static_cast<int32>(FMath::Min<int64>(Room, MAX_int32));
+}
+
+int32 URbsInventoryComponent::GetMaxAddable(const URbsInventoryItem* Item, FText* OutFailureText) const
+{
+	int32 MaxAddable = GetMaxAddableByWeight(Item->Weight);
+	if (OutFailureText && MaxAddable <= 0)
+	{
+		*OutFailureText = LOCTEXT("InventoryTooMuchWeightText", "Too Much Weight");
+	}
+
+	for (const URbsInventoryConstraint* Constraint : Constraints)
+	{
+		if (!Constraint || MaxAddable <= 0)
+			continue;
+
+		MaxAddable = FMath::Min(MaxAddable, Constraint->GetMaxAddable(Item));
+		if (OutFailureText && MaxAddable <= 0)
+		{
+			*OutFailureText = Constraint->FailureText;
+		}
+	}
+
+	return MaxAddable;
+}
+
+FRbsAddBudget URbsInventoryComponent::MakeAddBudget() const
+{
+	FRbsAddBudget Budget;
+	Budget.Weight = WeightCapacity - CachedWeight;
+	Budget.ConstraintHeadroom.SetNum(Constraints.Num());
+	for (int32 Index = 0; Index < Constraints.Num(); Index++)
+	{
+		if (Constraints[Index])
+		{
+			Constraints[Index]->GetHeadroom(Budget.ConstraintHeadroom[Index]);
+		}
+	}
+
+	return Budget;
+}
+
+int32 URbsInventoryComponent::GetMaxAddable(const URbsInventoryItem* Item, const FRbsAddBudget& Budget, FText* OutFailureText) const
+{
+	int32 MaxAddable = Item->Weight > 0.f ? FMath::FloorToInt(Budget.Weight / Item->Weight) : MAX_int32;
+	if (OutFailureText && MaxAddable <= 0)
+	{
+		*OutFailureText = LOCTEXT("InventoryTooMuchWeightText", "Too Much Weight");
+	}
+
+	for (int32 Index = 0; Index < Constraints.Num(); Index++)
+	{
+		if (!Constraints[Index] || MaxAddable <= 0)
+			continue;
+
+		MaxAddable = FMath::Min(MaxAddable, Constraints[Index]->GetMaxAddable(Item, Budget.ConstraintHeadroom[Index]));
+		if (OutFailureText && MaxAddable <= 0)
+		{
+			*OutFailureText = Constraints[Index]->FailureText;
+		}
+	}
+
+	return MaxAddable;
+}
+
+void URbsInventoryComponent::SpendAddBudget(const URbsInventoryItem* Item, const int32 Quantity, FRbsAddBudget& Budget) const
+{
+	Budget.Weight -= Quantity * Item->Weight;
+	for (int32 Index = 0; Index < Constraints.Num(); Index++)
+	{
+		if (Constraints[Index])
+		{
+			Constraints[Index]->SpendHeadroom(Item, Quantity, Budget.ConstraintHeadroom[Index]);
+		}
+	}
+}
+
+int32 URbsInventoryComponent::GetMaxAddableQuantity(TSubclassOf<URbsInventoryItem> ItemClass) const
+{
+	MaterializeLootForQuery();
+
+	return ItemClass ? FMath::Max(GetMaxAddable(ItemClass->GetDefaultObject<URbsInventoryItem>()), 0) : 0;
+}
+
+void URbsInventoryComponent::UpdateConstraints(const URbsInventoryItem* Item, const int32 Delta)
+{
+	for (URbsInventoryConstraint* Constraint : Constraints)
+	{
+		if (Constraint)
+		{
+			Constraint->AddQuantity(Item, Delta);
+		}
+	}
+}
+
+FItemAddResult URbsInventoryComponent::MakeAddResult(URbsInventoryItem* LastStack, const int32 AmountToGive, const int32 AmountGiven)
+{
+	if (AmountGiven <= 0)
+		return FItemAddResult::AddedNone(AmountToGive, LOCTEXT("InventoryCapacityFullText", "Inventory Is Full"));
+
+	if (AmountGiven < AmountToGive)
+		return FItemAddResult::AddedSome(LastStack, AmountToGive, AmountGiven, LOCTEXT("InventoryAddedSomeText", "Couldn't add all items"));
+
+	return FItemAddResult::AddedAll(LastStack, AmountToGive);
+}
+
+TArray<FItemAddResult> URbsInventoryComponent::TryAddItems(const TArray<FItemSpec>& ItemSpecs)
+{
+	MaterializeLoot();
+
+	TArray<FItemAddResult> Results;
+	Results.Reserve(ItemSpecs.Num());
+
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+	{
+		for (const FItemSpec& Spec : ItemSpecs)
+		{
+			Results.Add(FItemAddResult::AddedNone(Spec.Quantity, LOCTEXT("InventoryCallingFunctionsFromClient", "ERROR | You're trying to add items from a client")));
+		}
+		return Results;
+	}
+
+	//A brand new stack the batch will create, later specs of the same class can keep filling it
+	struct FPlannedStack
+	{
+		const UClass* ItemClass;
+		int32 Quantity;
+		URbsInventoryItem* Item;
+	};
+
+	//Where each spec ended up, AddedItem can only be filled once the new stacks exist
+	struct FPlannedResult
+	{
+		URbsInventoryItem* LastExistingStack = nullptr;
+		int32 LastNewStack = INDEX_NONE;
+	};
+
+	//How far into the existing stacks of a class we already are, full stacks are never looked at twice
+	struct FClassPlan
+	{
+		int32 StackCursor = 0;
+		int32 OpenNewStack = INDEX_NONE;
+	};
+
+	TArray<FPlannedStack> NewStacks;
+	TArray<FPlannedResult> PlannedResults;
+	PlannedResults.SetNum(ItemSpecs.Num());
+	TMap<URbsInventoryItem*, int32> TopUps;
+	TMap<const UClass*, FClassPlan> ClassPlans;
+
+	int32 FreeSlots = Capacity - CachedStackCount;
+
+	//Later specs see what the earlier ones will add, without touching the live totals
+	FRbsAddBudget Budget = MakeAddBudget();
+
+	//The new stacks are placed in the same order when applied, so the planned cells are the ones they get
+	FRbsInventoryGrid PlannedGrid = Grid;
+	FRbsGridPlacement PlannedPlacement;
+
+	//Plan
+	for (int32 SpecIndex = 0; SpecIndex < ItemSpecs.Num(); SpecIndex++)
+	{
+		const FItemSpec& Spec = ItemSpecs[SpecIndex];
+		if (!Spec.ItemClass || Spec.Quantity <= 0)
+		{
+			Results.Add(FItemAddResult::AddedNone(Spec.Quantity, LOCTEXT("InventoryErrorText", "Couldn't add any item")));
+			continue;
+		}
+
+		const URbsInventoryItem* Defaults = Spec.ItemClass->GetDefaultObject<URbsInventoryItem>();
+		FText FailureText;
+		int32 ActualAddAmount = FMath::Min(Spec.Quantity, GetMaxAddable(Defaults, Budget, &FailureText));
+		if (ActualAddAmount <= 0)
+		{
+			Results.Add(FItemAddResult::AddedNone(Spec.Quantity, FailureText));
+			continue;
+		}
+
+		FPlannedResult& Planned = PlannedResults[SpecIndex];
+		FClassPlan& ClassPlan = ClassPlans.FindOrAdd(Spec.ItemClass.Get());
+		const int32 StackSize = Defaults->bStackable ? Defaults->MaxStackSize : 1;
+		int32 AmountGiven = 0;
+
+		if (Defaults->bStackable)
+		{
+			const TConstArrayView<URbsInventoryItem*> Stacks = GetStacksOfClass(Spec.ItemClass);
+			while (ActualAddAmount > 0 && ClassPlan.StackCursor < Stacks.Num())
+			{
+				URbsInventoryItem* Stack = Stacks[ClassPlan.StackCursor];
+				int32& TopUp = TopUps.FindOrAdd(Stack);
+				const int32 StackAddAmount = FMath::Min(ActualAddAmount, Stack->MaxStackSize - Stack->GetQuantity() - TopUp);
+				if (StackAddAmount <= 0)
+				{
+					ClassPlan.StackCursor++;
+					continue;
+				}
+
+				TopUp += StackAddAmount;
+				ActualAddAmount -= StackAddAmount;
+				AmountGiven += StackAddAmount;
+				Planned.LastExistingStack = Stack;
+			}
+
+			if (ActualAddAmount > 0 && ClassPlan.OpenNewStack != INDEX_NONE)
+			{
+				FPlannedStack& OpenStack = NewStacks[ClassPlan.OpenNewStack];
+				const int32 StackAddAmount = FMath::Min(ActualAddAmount, StackSize - OpenStack.Quantity);
+				if (StackAddAmount > 0)
+				{
+					OpenStack.Quantity += StackAddAmount;
+					ActualAddAmount -= StackAddAmount;
+					AmountGiven += StackAddAmount;
+					Planned.LastNewStack = ClassPlan.OpenNewStack;
+				}
+			}
+		}
+
+		while (ActualAddAmount > 0 && FreeSlots > 0)
+		{
+			if (bUseGrid)
+			{
+				if (!FindGridSpace(Defaults, PlannedGrid, PlannedPlacement))
+					break;
+
+				PlannedGrid.Fill(PlannedPlacement.GetRect(Defaults->GridWidth, Defaults->GridHeight));
+			}
+
+			const int32 StackAddAmount = FMath::Min(ActualAddAmount, StackSize);
+			ClassPlan.OpenNewStack = NewStacks.Add({ Spec.ItemClass.Get(), StackAddAmount, nullptr });
+			Planned.LastNewStack = ClassPlan.OpenNewStack;
+			FreeSlots--;
+			ActualAddAmount -= StackAddAmount;
+			AmountGiven += StackAddAmount;
+		}
+
+		if (AmountGiven > 0)
+		{
+			SpendAddBudget(Defaults, AmountGiven, Budget);
+		}
+
+		if (AmountGiven <= 0)
+			Results.Add(FItemAddResult::AddedNone(Spec.Quantity, LOCTEXT("InventoryCapacityFullText", "Inventory Is Full")));
+		else if (AmountGiven < Spec.Quantity)
+			Results.Add(FItemAddResult::AddedSome(nullptr, Spec.Quantity, AmountGiven, LOCTEXT("InventoryAddedSomeText", "Couldn't add all items")));
+		else
+			Results.Add(FItemAddResult::AddedAll(nullptr, Spec.Quantity));
+	}
+
+	//Apply
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	for (const TPair<URbsInventoryItem*, int32>& TopUp : TopUps)
+	{
+		if (TopUp.Value > 0)
+		{
+			TopUp.Key->SetQuantity(TopUp.Key->GetQuantity() + TopUp.Value);
+		}
+	}
+
+	for (FPlannedStack& NewStack : NewStacks)
+	{
+		NewStack.Item = AddItemStack(const_cast<UClass*>(NewStack.ItemClass), NewStack.Quantity);
+	}
+
+	for (int32 SpecIndex = 0; SpecIndex < Results.Num(); SpecIndex++)
+	{
+		const FPlannedResult& Planned = PlannedResults[SpecIndex];
+		if (Planned.LastNewStack != INDEX_NONE)
+		{
+			Results[SpecIndex].AddedItem = NewStacks[Planned.LastNewStack].Item;
+		}
+		else if (Planned.LastExistingStack)
+		{
+			Results[SpecIndex].AddedItem = Planned.LastExistingStack;
+		}
+	}
+
+	return Results;
+}
+
+TArray<FItemAddResult> URbsInventoryComponent::TryAddLoot(const URbsLootTable* Table, const int32 Seed)
+{
+	if (!Table)
+		return TArray<FItemAddResult>();
+
+	return TryAddItems(Table->RollLootFromSeed(Seed));
+}
+
+int32 URbsInventoryComponent::TransferItem(URbsInventoryComponent* From, URbsInventoryComponent* To, URbsInventoryItem* Item, const int32 Quantity)
+{
+	if (!IsValid(From) || !IsValid(To) || From == To || Quantity <= 0)
+		return 0;
+
+	if (From->GetOwnerRole() < ROLE_Authority || To->GetOwnerRole() < ROLE_Authority || !From->ContainsItem(Item))
+		return 0;
+
+	To->MaterializeLoot();
+
+	//Everything To can't take stays where it is, nothing changes before we know how much moves
+	const int32 MoveAmount = FMath::Min3(FMath::Min(Quantity, Item->GetQuantity()), To->GetMaxAddable(Item), To->GetMaxAddableByStacks(Item));
+	if (MoveAmount <= 0)
+		return 0;
+
+	FRbsInventoryUpdateScope FromScope(From);
+	FRbsInventoryUpdateScope ToScope(To);
+
+	URbsInventoryItem* LastStack = nullptr;
+	int32 Remaining = MoveAmount;
+	if (Item->bStackable)
+	{
+		Remaining -= To->TopUpStacks(Item->GetClass(), Remaining, LastStack);
+	}
+
+	const int32 LeftInSource = Item->GetQuantity() - MoveAmount;
+
+	//Same actor channel, so clients just see the object change inventory
+	if (Remaining > 0 && LeftInSource == 0 && From->GetOwner() == To->GetOwner())
+	{
+		Item->SetQuantity(Remaining);
+		From->RemoveItem(Item);
+		To->AdoptItem(Item);
+		return MoveAmount;
+	}
+
+	const int32 StackSize = Item->bStackable ? Item->MaxStackSize : 1;
+	while (Remaining > 0)
+	{
+		const int32 StackAddAmount = FMath::Min(Remaining, StackSize);
+		To->AddItemStack(Item->GetClass(), StackAddAmount);
+		Remaining -= StackAddAmount;
+	}
+
+	if (LeftInSource > 0)
+	{
+		Item->SetQuantity(LeftInSource);
+	}
+	else
+	{
+		From->RemoveItem(Item);
+		From->RecycleItem(Item);
+	}
+
+	return MoveAmount;
+}
+
+FItemAddResult URbsInventoryComponent::TryAddDefinition(const URbsItemDefinition* Definition, const int32 Quantity)
+{
+	MaterializeLoot();
+
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+		return FItemAddResult::AddedNone(Quantity, LOCTEXT("InventoryCallingFunctionsFromClient", "ERROR | You're trying to add items from a client"));
+
+	if (!IsValid(Definition) || Quantity <= 0)
+		return FItemAddResult::AddedNone(Quantity, LOCTEXT("InventoryErrorText", "Couldn't add any item"));
+
+	int32 ActualAddAmount = FMath::Min(Quantity, GetMaxAddableByWeight(Definition->Weight));
+	if (ActualAddAmount <= 0)
+		return FItemAddResult::AddedNone(Quantity, LOCTEXT("InventoryTooMuchWeightText", "Too Much Weight"));
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	const int32 PlannedAmount = ActualAddAmount;
+	const int32 StackSize = Definition->GetStackSize();
+	if (Definition->bStackable)
+	{
+		for (FRbsItemInstance& Instance : ItemInstances.Entries)
+		{
+			if (ActualAddAmount <= 0)
+				break;
+
+			if (Instance.Definition != Definition)
+				continue;
+
+			const int32 StackAddAmount = FMath::Min(ActualAddAmount, StackSize - Instance.Quantity);
+			if (StackAddAmount <= 0)
+				continue;
+
+			Instance.Quantity += StackAddAmount;
+			ItemInstances.MarkItemDirty(Instance);
+			HandleInstanceChanged(Instance);
+			ActualAddAmount -= StackAddAmount;
+		}
+	}
+
+	while (ActualAddAmount > 0 && CachedStackCount < Capacity)
+	{
+		const int32 StackAddAmount = FMath::Min(ActualAddAmount, StackSize);
+		HandleInstanceAdded(ItemInstances.AddInstance(Definition, StackAddAmount));
+		ActualAddAmount -= StackAddAmount;
+	}
+
+	MarkItemInstancesDirty();
+	BroadcastInventoryUpdated();
+
+	return MakeAddResult(nullptr, Quantity, PlannedAmount - ActualAddAmount);
+}
+
+int32 URbsInventoryComponent::ConsumeDefinition(const URbsItemDefinition* Definition, const int32 Quantity)
+{
+	MaterializeLoot();
+
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+		return 0;
+
+	if (!IsValid(Definition) || Quantity <= 0)
+		return 0;
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	//Newest instances first, so the older stacks stay full. Removing the current index never shifts the ones still to visit
+	int32 Consumed = 0;
+	for (int32 Index = ItemInstances.Num() - 1; Index >= 0 && Consumed < Quantity; Index--)
+	{
+		if (ItemInstances.Entries[Index].Definition == Definition)
+		{
+			Consumed += ConsumeItemInstance(Index, Quantity - Consumed);
+		}
+	}
+
+	return Consumed;
+}
+
+int32 URbsInventoryComponent::ConsumeItemInstance(const int32 InstanceIndex, const int32 Quantity)
+{
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+		return 0;
+
+	if (!ItemInstances.Entries.IsValidIndex(InstanceIndex) || Quantity <= 0)
+		return 0;
+
+	FRbsItemInstance& Instance = ItemInstances.Entries[InstanceIndex];
+	const int32 RemoveQuantity = FMath::Min(Quantity, Instance.Quantity);
+	Instance.Quantity -= RemoveQuantity;
+
+	if (Instance.Quantity <= 0)
+	{
+		HandleInstanceRemoved(Instance);
+		ItemInstances.RemoveInstanceAt(InstanceIndex);
+	}
+	else
+	{
+		ItemInstances.MarkItemDirty(Instance);
+		HandleInstanceChanged(Instance);
+	}
+
+	MarkItemInstancesDirty();
+	BroadcastInventoryUpdated();
+
+	return RemoveQuantity;
+}
+
+void URbsInventoryComponent::SetItemInstanceValue(const int32 InstanceIndex, const FName Name, const float Value)
+{
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+		return;
+
+	if (!ItemInstances.Entries.IsValidIndex(InstanceIndex))
+		return;
+
+	FRbsItemInstance& Instance = ItemInstances.Entries[InstanceIndex];
+	Instance.SetValue(Name, Value);
+	ItemInstances.MarkItemDirty(Instance);
+	MarkItemInstancesDirty();
+	BroadcastInventoryUpdated();
+}
+
+bool URbsInventoryComponent::RemoveItem(URbsInventoryItem* Item)
+{
+	if (GetOwnerRole() < ROLE_Authority)
+		return false;
+
+	if (!IsValid(Item))
+		return false;
+
+	if (bUseGrid)
+	{
+		const int32 Index = Items.IndexOf(Item);
+		if (Index != INDEX_NONE)
+		{
+			Grid.Clear(Items.Entries[Index].GridPlacement.GetRect(Item->GridWidth, Item->GridHeight));
+		}
+	}
+
+	if (!Items.RemoveEntry(Item))
+		return false;
+
+	MarkItemsDirty();
+	HandleEntryRemoved(Item);
+	if (IsUsingRegisteredSubObjectList())
+	{
+		RemoveReplicatedSubObject(Item);
+		FNetConditionGroupManager::UnregisterSubObjectFromGroup(Item, GetDetailNetGroup());
+	}
+	Item->MarkDirtyForReplication();
+	
+	OnReplicated_Items();
+	
+	MarkSubobjectsDirty();
+	
+	return true;
+}
+
+int32 URbsInventoryComponent::ConsumeItem(URbsInventoryItem* Item)
+{
+	if (IsValid(Item))
+	{
+		return ConsumeItem(Item, Item->Quantity);
+	}
+	
+	return 0;
+}
+
+int32 URbsInventoryComponent::ConsumeItem(URbsInventoryItem* Item, const int32 Quantity)
+{
+	if (GetOwner()->GetLocalRole() < ROLE_Authority)
+		return 0;
+
+	//Stacks of other inventories are theirs to consume
+	if (!ContainsItem(Item))
+		return 0;
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	const int32 RemoveQuantity = FMath::Clamp(Quantity, 0, Item->GetQuantity());
+	if (RemoveQuantity <= 0)
+		return 0;
+
+	Item->SetQuantity(Item->GetQuantity() - RemoveQuantity);
+
+	if (Item->GetQuantity() <= 0)
+	{
+		if (RemoveItem(Item))
+		{
+			RecycleItem(Item);
+		}
+	}
+	else
+	{
+		ClientRefreshInventory();
+	}
+
+	return RemoveQuantity;
+}
+
+void URbsInventoryComponent::UseItem(URbsInventoryItem* Item)
+{
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		const uint16 Sequence = QueueInventoryCommand(ERbsInventoryCommandType::Use, Item);
+		if (Sequence == 0)
+		{
+			ServerUseItem(Item);
+		}
+		else if (Item->PredictedUseConsumption > 0)
+		{
+			PredictQuantityChange(Item, -FMath::Min(Item->PredictedUseConsumption, Item->GetQuantity()), Sequence);
+		}
+	}
+
+	if (GetOwner()->GetLocalRole() >= ROLE_Authority)
+	{
+		if (!ContainsItem(Item))
+			return;
+	}
+
+	if (IsValid(Item))
+	{
+		Item->Use(this);
+	}
+}
+
+void URbsInventoryComponent::ServerUseItem_Implementation(URbsInventoryItem* Item)
+{
+	UseItem(Item);
+}
+
+void URbsInventoryComponent::DropItem(URbsInventoryItem* Item, const int32 Quantity)
+{
+	if (!ContainsItem(Item))
+		return;
+
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		const uint16 Sequence = QueueInventoryCommand(ERbsInventoryCommandType::Drop, Item, Quantity);
+		if (Sequence == 0)
+		{
+			ServerDropItem(Item, Quantity);
+		}
+		else
+		{
+			PredictQuantityChange(Item, -FMath::Clamp(Quantity, 0, Item->GetQuantity()), Sequence);
+		}
+		return;
+	}
+	
+	//The stack may go back to the item pool once consumed
+	const TSubclassOf<AActor> PickupClass = Item->GetPickupClass();
+	const TSoftClassPtr<AActor> SoftPickupClass = Item->SoftPickupClass;
+	const int32 DroppedQuantity = ConsumeItem(Item, Quantity);
+	if (DroppedQuantity <= 0)
+		return;
+
+	const FTransform SpawnTransform = GetDropTransform();
+
+	if (PickupClass)
+	{
+		SpawnPickup(PickupClass, SpawnTransform, DroppedQuantity);
+		return;
+	}
+
+	if (!ensure(!SoftPickupClass.IsNull()))
+		return;
+
+	//The drop already happened, the pickup spawns where the item was dropped once its class is streamed in
+	const TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(SoftPickupClass.ToSoftObjectPath(),
+		FStreamableDelegate::CreateUObject(this, &ThisClass::OnPickupClassLoaded, SoftPickupClass, SpawnTransform, DroppedQuantity));
+
+	if (!Handle.IsValid())
+	{
+		SpawnPickup(SoftPickupClass.LoadSynchronous(), SpawnTransform, DroppedQuantity);
+	}
+}
+
+void URbsInventoryComponent::OnPickupClassLoaded(TSoftClassPtr<AActor> SoftPickupClass, FTransform SpawnTransform, int32 Quantity)
+{
+	//A failed or cancelled stream still has to end up with a pickup
+	UClass* PickupClass = SoftPickupClass.Get();
+	if (!PickupClass)
+	{
+		PickupClass = SoftPickupClass.LoadSynchronous();
+	}
+
+	SpawnPickup(PickupClass, SpawnTransform, Quantity);
+}
+
+void URbsInventoryComponent::SpawnPickup(UClass* PickupClass, const FTransform& SpawnTransform, const int32 Quantity)
+{
+	if (!ensure(PickupClass) || !GetWorld())
+		return;
+
+	URbsPickupPoolSubsystem* PickupPool = bUsePickupPool || bCoalesceDrops ? GetWorld()->GetSubsystem<URbsPickupPoolSubsystem>() : nullptr;
+
+	//Fold the drop into a pickup of the same class that was just dropped next to it
+	if (bCoalesceDrops && PickupPool)
+	{
+		if (AActor* RecentPickup = PickupPool->FindRecentDrop(PickupClass, SpawnTransform.GetLocation(), DropCoalesceRadius, DropCoalesceWindow))
+		{
+			const int32 RecentQuantity = IRbsPickupInterface::Execute_GetPickupQuantity(RecentPickup);
+			if (RecentQuantity != INDEX_NONE)
+			{
+				IRbsPickupInterface::Execute_SetPickupQuantity(RecentPickup, RecentQuantity + Quantity);
+				PickupPool->RegisterDrop(RecentPickup);
+				return;
+			}
+		}
+	}
+
+	AActor* Pickup = nullptr;
+	if (bUsePickupPool && PickupPool)
+	{
+		Pickup = PickupPool->AcquirePickup(PickupClass, SpawnTransform, GetOwner());
+	}
+	else
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Owner = GetOwner();
+		SpawnParams.bNoFail = true;
+		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+		Pickup = GetWorld()->SpawnActor<AActor>(PickupClass, SpawnTransform, SpawnParams);
+	}
+
+	IRbsPickupInterface::Execute_SetPickupQuantity(Pickup, Quantity);
+	IRbsPickupInterface::Execute_OnDropItem(Pickup);
+
+	if (PickupPool)
+	{
+		PickupPool->RegisterDrop(Pickup);
+	}
+}
+
+FTransform URbsInventoryComponent::GetDropTransform() const
+{
+	//Characters drop at their feet, anything else where it stands
+	FVector SpawnLocation = GetOwner()->GetActorLocation();
+	if (const ACharacter* Character = Cast<ACharacter>(GetOwner()))
+	{
+		SpawnLocation.Z -= Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	}
+
+	return FTransform(GetOwner()->GetActorRotation(), SpawnLocation);
+}
+
+void URbsInventoryComponent::ServerDropItem_Implementation(URbsInventoryItem* Item, const int32 Quantity)
+{
+	//A negative drop would add to the stack
+	if (Quantity <= 0)
+		return;
+
+	DropItem(Item, Quantity);
+}
+
+URbsInventoryItem* URbsInventoryComponent::SplitStack(URbsInventoryItem* Item, const int32 Quantity)
+{
+	if (!ContainsItem(Item) || Quantity <= 0 || Quantity >= Item->GetQuantity())
+		return nullptr;
+
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		QueueInventoryCommand(ERbsInventoryCommandType::Split, Item, Quantity);
+		return nullptr;
+	}
+
+	if (!CanAddStack(Item))
+		return nullptr;
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	Item->SetQuantity(Item->GetQuantity() - Quantity);
+	return AddItemStack(Item->GetClass(), Quantity);
+}
+
+bool URbsInventoryComponent::MoveItem(URbsInventoryItem* Item, const int32 NewIndex)
+{
+	if (!ContainsItem(Item) || !Items.Entries.IsValidIndex(NewIndex))
+		return false;
+
+	if (GetOwnerRole() < ROLE_Authority)
+		return QueueInventoryCommand(ERbsInventoryCommandType::Move, Item, 0, NewIndex) != 0;
+
+	const int32 Index = Items.IndexOf(Item);
+	if (Index == INDEX_NONE)
+		return false;
+
+	if (Index != NewIndex)
+	{
+		Items.MoveEntry(Index, NewIndex);
+		MarkItemsDirty();
+		BroadcastInventoryUpdated();
+	}
+
+	return true;
+}
+
+int32 URbsInventoryComponent::ConsolidateStacks()
+{
+	if (GetOwnerRole() < ROLE_Authority)
+		return 0;
+
+	MaterializeLoot();
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	//Pour each class into its first stacks, the stacks left empty are removed once we're done walking the buckets
+	TArray<URbsInventoryItem*> EmptiedStacks;
+	for (const TPair<const UClass*, FRbsItemClassBucket>& Pair : ClassBuckets)
+	{
+		const TConstArrayView<URbsInventoryItem*> Stacks = Pair.Value.Stacks;
+		if (Stacks.Num() < 2 || !Stacks[0]->bStackable)
+			continue;
+
+		int32 Left = Pair.Value.Quantity;
+		for (URbsInventoryItem* Stack : Stacks)
+		{
+			const int32 Fill = FMath::Min(Left, Stack->MaxStackSize);
+			Stack->SetQuantity(Fill);
+			Left -= Fill;
+
+			if (Fill <= 0)
+			{
+				EmptiedStacks.Add(Stack);
+			}
+		}
+	}
+
+	for (URbsInventoryItem* Stack : EmptiedStacks)
+	{
+		RemoveItem(Stack);
+		RecycleItem(Stack);
+	}
+
+	return EmptiedStacks.Num();
+}
+
+bool URbsInventoryComponent::PlaceItemInGrid(URbsInventoryItem* Item, const int32 X, const int32 Y, const bool bRotated)
+{
+	if (!bUseGrid || GetOwnerRole() < ROLE_Authority)
+		return false;
+
+	const int32 Index = Items.IndexOf(Item);
+	if (!IsValid(Item) || Index == INDEX_NONE)
+		return false;
+
+	FRbsInventoryEntry& Entry = Items.Entries[Index];
+	const FRbsGridPlacement NewPlacement(X, Y, bRotated);
+	if (Entry.GridPlacement == NewPlacement)
+		return true;
+
+	const FIntRect OldRect = Entry.GridPlacement.GetRect(Item->GridWidth, Item->GridHeight);
+	const FIntRect NewRect = NewPlacement.GetRect(Item->GridWidth, Item->GridHeight);
+	if (!Grid.IsFree(NewRect, OldRect))
+		return false;
+
+	Grid.Clear(OldRect);
+	Grid.Fill(NewRect);
+	Entry.GridPlacement = NewPlacement;
+	Items.MarkItemDirty(Entry);
+	MarkItemsDirty();
+	BroadcastInventoryUpdated();
+
+	return true;
+}
+
+bool URbsInventoryComponent::RotateItemInGrid(URbsInventoryItem* Item)
+{
+	const FRbsGridPlacement Placement = GetItemGridPlacement(Item);
+	if (!Placement.IsValid())
+		return false;
+
+	return PlaceItemInGrid(Item, Placement.X, Placement.Y, !Placement.bRotated);
+}
+
+bool URbsInventoryComponent::CanPlaceItemInGrid(const URbsInventoryItem* Item, const int32 X, const int32 Y, const bool bRotated) const
+{
+	if (!bUseGrid || !IsValid(Item))
+		return false;
+
+	const FIntRect OldRect = GetItemGridPlacement(Item).GetRect(Item->GridWidth, Item->GridHeight);
+	return Grid.IsFree(FRbsGridPlacement(X, Y, bRotated).GetRect(Item->GridWidth, Item->GridHeight), OldRect);
+}
+
+FRbsGridPlacement URbsInventoryComponent::GetItemGridPlacement(const URbsInventoryItem* Item) const
+{
+	const int32 Index = Items.IndexOf(Item);
+	return Index != INDEX_NONE ? Items.Entries[Index].GridPlacement : FRbsGridPlacement();
+}
+
+void URbsInventoryComponent::SortItems(const ERbsItemSortKey Key)
+{
+	if (GetOwnerRole() < ROLE_Authority)
+		return;
+
+	MaterializeLoot();
+
+	const int32 Count = Items.Num();
+	if (Count < 2)
+		return;
+
+	//Names are only compared once per class, the sort itself works on the ranks
+	TArray<const UClass*> Classes;
+	ClassBuckets.GetKeys(Classes);
+	if (Key == ERbsItemSortKey::Category)
+	{
+		Classes.Sort([](const UClass& A, const UClass& B)
+		{
+			const int32 Compare = A.GetDefaultObject<URbsInventoryItem>()->Category.CompareTo(B.GetDefaultObject<URbsInventoryItem>()->Category);
+			return Compare != 0 ? Compare < 0 : A.GetFName().LexicalLess(B.GetFName());
+		});
+	}
+	else
+	{
+		Classes.Sort([](const UClass& A, const UClass& B) { return A.GetFName().LexicalLess(B.GetFName()); });
+	}
+
+	TMap<const UClass*, uint32> ClassRanks;
+	ClassRanks.Reserve(Classes.Num());
+	for (int32 i = 0; i < Classes.Num(); i++)
+	{
+		ClassRanks.Add(Classes[i], i);
+	}
+
+	//One 64 bit key per entry: the sort value on top and the current index below it, so ties keep their order
+	TArray<uint64> SortKeys;
+	SortKeys.SetNumUninitialized(Count);
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		const URbsInventoryItem* Item = Items.Entries[Index].Item;
+
+		uint32 Primary = MAX_uint32;
+		if (Item)
+		{
+			switch (Key)
+			{
+			case ERbsItemSortKey::Weight:
+			{
+				//The bits of a positive float sort like the float itself
+				const float StackWeight = FMath::Max(Item->GetStackWeight(), 0.f);
+				uint32 WeightBits;
+				FMemory::Memcpy(&WeightBits, &StackWeight, sizeof(WeightBits));
+				Primary = MAX_uint32 - WeightBits;
+				break;
+			}
+			case ERbsItemSortKey::Quantity:
+				Primary = MAX_uint32 - static_cast<uint32>(FMath::Max(Item->GetQuantity(), 0));
+				break;
+			default:
+				Primary = ClassRanks.FindRef(Item->GetClass());
+				break;
+			}
+		}
+
+		SortKeys[Index] = (uint64(Primary) << 32) | uint64(Index);
+	}
+
+	SortKeys.Sort();
+
+	TArray<int32> NewOrder;
+	NewOrder.SetNumUninitialized(Count);
+	for (int32 Index = 0; Index < Count; Index++)
+	{
+		NewOrder[Index] = static_cast<int32>(SortKeys[Index] & MAX_uint32);
+	}
+
+	Items.ReorderEntries(NewOrder);
+	MarkItemsDirty();
+	BroadcastInventoryUpdated();
+}
+
+uint16 URbsInventoryComponent::QueueInventoryCommand(const ERbsInventoryCommandType Type, const URbsInventoryItem* Item, const int32 Quantity, const int32 TargetIndex)
+{
+	if (!IsValid(Item) || !Item->GetItemHandle().IsValid())
+		return 0;
+
+	FRbsInventoryCommand& Command = PendingCommands.AddDefaulted_GetRef();
+	Command.Sequence = NextCommandSequence;
+	Command.Type = Type;
+	Command.Handle = Item->GetItemHandle();
+	Command.Quantity = Quantity;
+	Command.TargetIndex = TargetIndex;
+
+	//0 means not queued
+	if (++NextCommandSequence == 0)
+	{
+		NextCommandSequence = 1;
+	}
+
+	if (!bCommandFlushScheduled && GetWorld())
+	{
+		bCommandFlushScheduled = true;
+		GetWorld()->GetTimerManager().SetTimerForNextTick(this, &ThisClass::FlushInventoryCommands);
+	}
+
+	return Command.Sequence;
+}
+
+void URbsInventoryComponent::FlushInventoryCommands()
+{
+	bCommandFlushScheduled = false;
+
+	for (int32 Start = 0; Start < PendingCommands.Num(); Start += MaxCommandsPerBatch)
+	{
+		const int32 Count = FMath::Min(MaxCommandsPerBatch, PendingCommands.Num() - Start);
+		ServerExecuteInventoryCommands(TArray<FRbsInventoryCommand>(PendingCommands.GetData() + Start, Count));
+	}
+
+	PendingCommands.Reset();
+}
+
+void URbsInventoryComponent::ServerExecuteInventoryCommands_Implementation(const TArray<FRbsInventoryCommand>& Commands)
+{
+	if (Commands.Num() == 0)
+		return;
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	//The client never sends more than a batch at once, anything past it is rejected unread
+	TArray<uint16> RejectedSequences;
+	for (int32 Index = 0; Index < Commands.Num(); Index++)
+	{
+		if (Index >= MaxCommandsPerBatch || !ExecuteInventoryCommand(Commands[Index]))
+		{
+			RejectedSequences.Add(Commands[Index].Sequence);
+		}
+	}
+
+	ClientAckInventoryCommands(Commands.Last().Sequence, RejectedSequences);
+}
+
+bool URbsInventoryComponent::ExecuteInventoryCommand(const FRbsInventoryCommand& Command)
+{
+	URbsInventoryItem* Item = ResolveItemHandle(Command.Handle);
+	if (!Item)
+		return false;
+
+	switch (Command.Type)
+	{
+	case ERbsInventoryCommandType::Use:
+		UseItem(Item);
+		return true;
+
+	case ERbsInventoryCommandType::Drop:
+		if (Command.Quantity <= 0)
+			return false;
+
+		DropItem(Item, Command.Quantity);
+		return true;
+
+	case ERbsInventoryCommandType::Split:
+		return SplitStack(Item, Command.Quantity) != nullptr;
+
+	case ERbsInventoryCommandType::Move:
+		return MoveItem(Item, Command.TargetIndex);
+	}
+
+	return false;
+}
+
+void URbsInventoryComponent::ClientAckInventoryCommands_Implementation(uint16 LastSequence, const TArray<uint16>& RejectedSequences)
+{
+	if (FRbsInventoryCommand::IsSequenceNewer(LastSequence, LastAckedCommandSequence))
+	{
+		LastAckedCommandSequence = LastSequence;
+	}
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	//The UI may already show what the client asked for
+	if (RejectedSequences.Num() > 0)
+	{
+		BroadcastInventoryUpdated();
+	}
+
+	const double Now = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.0;
+	bool bHasAckedPredictions = false;
+	for (int32 Index = PendingPredictions.Num() - 1; Index >= 0; Index--)
+	{
+		FRbsQuantityPrediction& Prediction = PendingPredictions[Index];
+		if (FRbsInventoryCommand::IsSequenceNewer(Prediction.Sequence, LastSequence))
+			continue;
+
+		if (RejectedSequences.Contains(Prediction.Sequence))
+		{
+			URbsInventoryItem* Item = Prediction.Item.Get();
+			RemovePrediction(Index);
+			if (Item && !DeferItemModified(Item))
+			{
+				Item->OnItemModified.Broadcast();
+			}
+			continue;
+		}
+
+		//The new quantity usually replicates right after the ack, keep showing the prediction until it does
+		if (!Prediction.bAcked)
+		{
+			Prediction.bAcked = true;
+			Prediction.AckTime = Now;
+		}
+		bHasAckedPredictions = true;
+	}
+
+	if (bHasAckedPredictions && GetWorld() && !GetWorld()->GetTimerManager().IsTimerActive(PredictionTimeoutTimer))
+	{
+		GetWorld()->GetTimerManager().SetTimer(PredictionTimeoutTimer, this, &ThisClass::ExpirePredictions, PredictionTimeout);
+	}
+}
+
+void URbsInventoryComponent::PredictQuantityChange(URbsInventoryItem* Item, const int32 QuantityDelta, const uint16 Sequence)
+{
+	if (QuantityDelta == 0)
+		return;
+
+	FRbsQuantityPrediction& Prediction = PendingPredictions.AddDefaulted_GetRef();
+	Prediction.Sequence = Sequence;
+	Prediction.Item = Item;
+	Prediction.QuantityDelta = QuantityDelta;
+	Prediction.TargetQuantity = Item->GetQuantity() + QuantityDelta;
+	Item->PredictedQuantityDelta += QuantityDelta;
+
+	if (!DeferItemModified(Item))
+	{
+		Item->OnItemModified.Broadcast();
+	}
+}
+
+void URbsInventoryComponent::RemovePrediction(const int32 Index)
+{
+	if (URbsInventoryItem* Item = PendingPredictions[Index].Item.Get())
+	{
+		Item->PredictedQuantityDelta -= PendingPredictions[Index].QuantityDelta;
+	}
+
+	PendingPredictions.RemoveAt(Index);
+}
+
+void URbsInventoryComponent::RetireConfirmedPredictions(const URbsInventoryItem* Item)
+{
+	const int32 ServerQuantity = Item->GetAuthoritativeQuantity();
+	for (int32 Index = PendingPredictions.Num() - 1; Index >= 0; Index--)
+	{
+		const FRbsQuantityPrediction& Prediction = PendingPredictions[Index];
+		if (Prediction.Item != Item)
+			continue;
+
+		const bool bReachedTarget = Prediction.QuantityDelta < 0 ? ServerQuantity <= Prediction.TargetQuantity : ServerQuantity >= Prediction.TargetQuantity;
+		if (Prediction.bAcked || bReachedTarget)
+		{
+			RemovePrediction(Index);
+		}
+	}
+}
+
+void URbsInventoryComponent::DiscardPredictions(const URbsInventoryItem* Item)
+{
+	for (int32 Index = PendingPredictions.Num() - 1; Index >= 0; Index--)
+	{
+		if (PendingPredictions[Index].Item == Item)
+		{
+			RemovePrediction(Index);
+		}
+	}
+}
+
+void URbsInventoryComponent::ExpirePredictions()
+{
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	//Acknowledged, but the quantity never came back changed, so the server didn't do what we predicted
+	const double Now = GetWorld()->GetTimeSeconds();
+	double NextExpiry = MAX_dbl;
+	for (int32 Index = PendingPredictions.Num() - 1; Index >= 0; Index--)
+	{
+		const FRbsQuantityPrediction& Prediction = PendingPredictions[Index];
+		if (!Prediction.bAcked)
+			continue;
+
+		if (Now - Prediction.AckTime < PredictionTimeout)
+		{
+			NextExpiry = FMath::Min(NextExpiry, Prediction.AckTime + PredictionTimeout);
+			continue;
+		}
+
+		URbsInventoryItem* Item = Prediction.Item.Get();
+		RemovePrediction(Index);
+		if (Item && !DeferItemModified(Item))
+		{
+			Item->OnItemModified.Broadcast();
+		}
+	}
+
+	if (NextExpiry < MAX_dbl)
+	{
+		GetWorld()->GetTimerManager().SetTimer(PredictionTimeoutTimer, this, &ThisClass::ExpirePredictions, static_cast<float>(FMath::Max(NextExpiry - Now, UE_KINDA_SMALL_NUMBER)));
+	}
+}
+
+void URbsInventoryComponent::OnItemModified_Internal()
+{
+	BroadcastInventoryUpdated();
+}
+
+/*
+ * Helpers
+ */
+
+bool URbsInventoryComponent::HasItem(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity, const bool bIncludeChildClasses) const
+{
+	return GetTotalQuantity(ItemClass, bIncludeChildClasses) >= Quantity;
+}
+
+bool URbsInventoryComponent::HasItems(const FRbsItemRequirements& Requirements) const
+{
+	return CountItems(Requirements) > 0;
+}
+
+int32 URbsInventoryComponent::CountItems(const FRbsItemRequirements& Requirements) const
+{
+	MaterializeLootForQuery();
+
+	int32 Count = MAX_int32;
+	for (const TPair<TSubclassOf<URbsInventoryItem>, int32>& Requirement : Requirements.Items)
+	{
+		if (Requirement.Value <= 0)
+			continue;
+
+		const FRbsItemClassBucket* Bucket = ClassBuckets.Find(Requirement.Key.Get());
+		Count = FMath::Min(Count, Bucket ? Bucket->Quantity / Requirement.Value : 0);
+		if (Count == 0)
+			break;
+	}
+
+	//Nothing required, it can be met any number of times
+	return Count;
+}
+
+TArray<int32> URbsInventoryComponent::CountItemsBulk(const TArray<FRbsItemRequirements>& RequirementSets) const
+{
+	TArray<int32> Counts;
+	Counts.SetNumUninitialized(RequirementSets.Num());
+	for (int32 Index = 0; Index < RequirementSets.Num(); Index++)
+	{
+		Counts[Index] = CountItems(RequirementSets[Index]);
+	}
+
+	return Counts;
+}
+
+bool URbsInventoryComponent::ConsumeItems(const FRbsItemRequirements& Requirements)
+{
+	if (GetOwnerRole() < ROLE_Authority)
+		return false;
+
+	MaterializeLoot();
+	if (!HasItems(Requirements))
+		return false;
+
+	FRbsInventoryUpdateScope UpdateScope(this);
+
+	for (const TPair<TSubclassOf<URbsInventoryItem>, int32>& Requirement : Requirements.Items)
+	{
+		if (Requirement.Value <= 0)
+			continue;
+
+		//Copied, consuming a stack whole removes it from the bucket
+		const TArray<URbsInventoryItem*> Stacks(GetStacksOfClass(Requirement.Key.Get()));
+		int32 Left = Requirement.Value;
+		for (int32 Index = Stacks.Num() - 1; Index >= 0 && Left > 0; Index--)
+		{
+			URbsInventoryItem* Stack = Stacks[Index];
+			const int32 RemoveQuantity = FMath::Min(Left, Stack->GetQuantity());
+			Stack->SetQuantity(Stack->GetQuantity() - RemoveQuantity);
+			Left -= RemoveQuantity;
+
+			if (Stack->GetQuantity() <= 0)
+			{
+				RemoveItem(Stack);
+				RecycleItem(Stack);
+			}
+		}
+
+		ensure(Left == 0);
+	}
+
+	//Once for the whole set, instead of once per stack like ConsumeItem
+	ClientRefreshInventory();
+
+	return true;
+}
+
+URbsInventoryItem* URbsInventoryComponent::ResolveItemHandle(const FRbsItemHandle& Handle) const
+{
+	if (!HandleSlots.IsValidIndex(Handle.Index))
+		return nullptr;
+
+	const FRbsItemHandleSlot& Slot = HandleSlots[Handle.Index];
+	return Slot.Generation == Handle.Generation ? Slot.Item : nullptr;
+}
+
+URbsInventoryItem* URbsInventoryComponent::FindItem(URbsInventoryItem* Item) const
+{
+	return FindItemByClass(Item->GetClass());
+}
+
+TArray<URbsInventoryItem*> URbsInventoryComponent::FindItems(URbsInventoryItem* Item) const
+{
+	return FindItemsByClass(Item->GetClass());
+}
+
+URbsInventoryItem* URbsInventoryComponent::FindItemByClass(TSubclassOf<URbsInventoryItem> ItemClass) const
+{
+	const TConstArrayView<URbsInventoryItem*> Stacks = GetStacksOfClass(ItemClass);
+	return Stacks.Num() > 0 ? Stacks[0] : nullptr;
+}
+
+TArray<URbsInventoryItem*> URbsInventoryComponent::FindItemsByClass(TSubclassOf<URbsInventoryItem> ItemClass, const bool bIncludeChildClasses) const
+{
+	MaterializeLootForQuery();
+
+	if (!bIncludeChildClasses)
+		return TArray<URbsInventoryItem*>(GetStacksOfClass(ItemClass));
+
+	//Walk the distinct classes we hold rather than every stack
+	TArray<URbsInventoryItem*> ItemsOfClas{};
+	for (const TPair<const UClass*, FRbsItemClassBucket>& Pair : ClassBuckets)
+	{
+		if (Pair.Key->IsChildOf(ItemClass))
+		{
+			ItemsOfClas.Append(Pair.Value.Stacks);
+		}
+	}
+
+	return ItemsOfClas;
+}
+
+TConstArrayView<URbsInventoryItem*> URbsInventoryComponent::GetStacksOfClass(const UClass* ItemClass) const
+{
+	MaterializeLootForQuery();
+
+	const FRbsItemClassBucket* Bucket = ClassBuckets.Find(ItemClass);
+	return Bucket ? TConstArrayView<URbsInventoryItem*>(Bucket->Stacks) : TConstArrayView<URbsInventoryItem*>();
+}
+
+TArray<URbsInventoryItem*> URbsInventoryComponent::GetItems() const
+{
+	MaterializeLootForQuery();
+
+	TArray<URbsInventoryItem*> AllItems;
+	AllItems.Reserve(Items.Num());
+	for (URbsInventoryItem* Item : ViewItems())
+	{
+		AllItems.Add(Item);
+	}
+
+	return AllItems;
+}
+
+URbsInventoryItem* URbsInventoryComponent::GetItemAt(const int32 Index) const
+{
+	MaterializeLootForQuery();
+
+	return Items.Entries.IsValidIndex(Index) ? Items.Entries[Index].Item.Get() : nullptr;
+}
+
+FRbsItemInstance URbsInventoryComponent::GetItemInstanceAt(const int32 Index) const
+{
+	MaterializeLootForQuery();
+
+	return ItemInstances.Entries.IsValidIndex(Index) ? ItemInstances.Entries[Index] : FRbsItemInstance();
+}
+
+int32 URbsInventoryComponent::GetDefinitionQuantity(const URbsItemDefinition* Definition) const
+{
+	MaterializeLootForQuery();
+
+	const int32* Quantity = DefinitionQuantities.Find(Definition);
+	return Quantity ? *Quantity : 0;
+}
+
+int32 URbsInventoryComponent::GetTotalQuantity(TSubclassOf<URbsInventoryItem> ItemClass, const bool bIncludeChildClasses) const
+{
+	MaterializeLootForQuery();
+
+	if (!bIncludeChildClasses)
+	{
+		const FRbsItemClassBucket* Bucket = ClassBuckets.Find(ItemClass.Get());
+		return Bucket ? Bucket->Quantity : 0;
+	}
+
+	int32 Quantity = 0;
+	for (const TPair<const UClass*, FRbsItemClassBucket>& Pair : ClassBuckets)
+	{
+		if (Pair.Key->IsChildOf(ItemClass))
+		{
+			Quantity += Pair.Value.Quantity;
+		}
+	}
+
+	return Quantity;
+}
+
+void URbsInventoryComponent::SetWeightCapacity(const float NewWeightCapacity)
+{
+	WeightCapacity = NewWeightCapacity;
+	BroadcastInventoryUpdated();
+}
+
+void URbsInventoryComponent::SetCapacity(const int32 NewCapacity)
+{
+	Capacity = NewCapacity;
+	BroadcastInventoryUpdated();
+}
+
+void URbsInventoryComponent::OnReplicated_Items()
+{
+	BroadcastInventoryUpdated();
+}
+
+void URbsInventoryComponent::HandleEntryAdded(URbsInventoryItem* Item, const FRbsItemHandle& Handle)
+{
+	if (!IsValid(Item) || Item->OwningInventory == this)
+		return;
+
+	Item->OwningInventory = this;
+	Item->AccountedQuantity = Item->Quantity;
+	Item->Handle = Handle;
+
+	if (Handle.IsValid())
+	{
+		if (!HandleSlots.IsValidIndex(Handle.Index))
+		{
+			HandleSlots.SetNum(Handle.Index + 1);
+		}
+		HandleSlots[Handle.Index] = { Item, Handle.Generation };
+	}
+
+	FRbsItemClassBucket& Bucket = ClassBuckets.FindOrAdd(Item->GetClass());
+	Bucket.Quantity += Item->AccountedQuantity;
+	Bucket.Stacks.Add(Item);
+	bBucketsNeedSort |= GetOwnerRole() < ROLE_Authority;
+	CachedWeight += Item->AccountedQuantity * Item->Weight;
+	CachedStackCount++;
+	UpdateConstraints(Item, Item->AccountedQuantity);
+	VerifyAggregates();
+
+	Item->OnItemModified.AddUniqueDynamic(this, &ThisClass::OnItemModified_Internal);
+	OnItemAdded.Broadcast(Item);
+}
+
+void URbsInventoryComponent::HandleEntryRemoved(URbsInventoryItem* Item)
+{
+	if (!IsValid(Item) || Item->OwningInventory != this)
+		return;
+
+	Item->OwningInventory = nullptr;
+	DiscardPredictions(Item);
+
+	//Free the slot, the next stack to take it gets a new generation so handles to this one stop resolving
+	const int32 HandleIndex = Item->Handle.Index;
+	if (HandleSlots.IsValidIndex(HandleIndex) && HandleSlots[HandleIndex].Item == Item)
+	{
+		HandleSlots[HandleIndex].Item = nullptr;
+		if (GetOwnerRole() == ROLE_Authority)
+		{
+			HandleSlots[HandleIndex].Generation++;
+			FreeHandleSlots.Add(HandleIndex);
+		}
+	}
+	Item->Handle = FRbsItemHandle();
+
+	FRbsItemClassBucket& Bucket = ClassBuckets.FindChecked(Item->GetClass());
+	Bucket.Quantity -= Item->AccountedQuantity;
+	Bucket.Stacks.RemoveSingle(Item);
+	if (Bucket.Stacks.Num() == 0)
+	{
+		ClassBuckets.Remove(Item->GetClass());
+	}
+	CachedWeight -= Item->AccountedQuantity * Item->Weight;
+	CachedStackCount--;
+	UpdateConstraints(Item, -Item->AccountedQuantity);
+	Item->AccountedQuantity = 0;
+	VerifyAggregates();
+
+	Item->OnItemModified.RemoveDynamic(this, &ThisClass::OnItemModified_Internal);
+	OnItemRemoved.Broadcast(Item);
+
+	//The server pool hands this same object out again as a new stack, ResetForReuse only runs there
+	if (GetOwnerRole() < ROLE_Authority)
+	{
+		Item->OnItemModified.Clear();
+		Item->bPendingModifiedBroadcast = false;
+		Item->PredictedQuantityDelta = 0;
+	}
+}
+
+void URbsInventoryComponent::HandleEntriesReordered()
+{
+	bool bOrderChanged = false;
+	for (const FRbsInventoryEntry& Entry : Items.Entries)
+	{
+		if (Entry.Item && Entry.Item->OwningInventory == this && Entry.Item->EntryOrder != Entry.Order)
+		{
+			Entry.Item->EntryOrder = Entry.Order;
+			bOrderChanged = true;
+		}
+	}
+
+	if (!bOrderChanged && !bBucketsNeedSort)
+		return;
+
+	bBucketsNeedSort = false;
+	for (TPair<const UClass*, FRbsItemClassBucket>& Pair : ClassBuckets)
+	{
+		Pair.Value.Stacks.Sort([](const URbsInventoryItem& A, const URbsInventoryItem& B) { return A.EntryOrder < B.EntryOrder; });
+	}
+}
+
+void URbsInventoryComponent::HandleItemQuantityChanged(URbsInventoryItem* Item)
+{
+	RetireConfirmedPredictions(Item);
+
+	//Clients may receive the new quantity before or after the entry itself, only count the difference we haven't seen yet
+	const int32 Delta = Item->Quantity - Item->AccountedQuantity;
+	if (Delta == 0)
+		return;
+
+	Item->AccountedQuantity = Item->Quantity;
+	ClassBuckets.FindChecked(Item->GetClass()).Quantity += Delta;
+	CachedWeight += Delta * Item->Weight;
+	UpdateConstraints(Item, Delta);
+	VerifyAggregates();
+}
+
+void URbsInventoryComponent::HandleInstanceAdded(FRbsItemInstance& Instance)
+{
+	if (Instance.bCounted)
+		return;
+
+	Instance.bCounted = true;
+	CachedStackCount++;
+	AccountInstance(Instance, Instance.Definition, Instance.Quantity);
+}
+
+void URbsInventoryComponent::HandleInstanceRemoved(FRbsItemInstance& Instance)
+{
+	if (!Instance.bCounted)
+		return;
+
+	Instance.bCounted = false;
+	CachedStackCount--;
+	AccountInstance(Instance, nullptr, 0);
+}
+
+void URbsInventoryComponent::HandleInstanceChanged(FRbsItemInstance& Instance)
+{
+	//The definition may resolve on clients after the instance was added
+	if (!Instance.bCounted)
+	{
+		HandleInstanceAdded(Instance);
+		return;
+	}
+
+	AccountInstance(Instance, Instance.Definition, Instance.Quantity);
+}
+
+void URbsInventoryComponent::AccountInstance(FRbsItemInstance& Instance, const URbsItemDefinition* Definition, const int32 Quantity)
+{
+	if (Instance.AccountedDefinition == Definition && Instance.AccountedQuantity == Quantity)
+	{
+		VerifyAggregates();
+		return;
+	}
+
+	if (const URbsItemDefinition* OldDefinition = Instance.AccountedDefinition)
+	{
+		CachedWeight -= Instance.AccountedQuantity * OldDefinition->Weight;
+		int32& OldQuantity = DefinitionQuantities.FindChecked(OldDefinition);
+		OldQuantity -= Instance.AccountedQuantity;
+		if (OldQuantity == 0)
+		{
+			DefinitionQuantities.Remove(OldDefinition);
+		}
+	}
+
+	Instance.AccountedDefinition = Definition;
+	Instance.AccountedQuantity = Definition ? Quantity : 0;
+
+	if (Definition)
+	{
+		CachedWeight += Instance.AccountedQuantity * Definition->Weight;
+		DefinitionQuantities.FindOrAdd(Definition) += Instance.AccountedQuantity;
+	}
+
+	VerifyAggregates();
+}
+
+#if RBS_VERIFY_INVENTORY_AGGREGATES
+void URbsInventoryComponent::VerifyAggregates() const
+{
+	double Weight = 0.0;
+	int32 StackCount = 0;
+	TMap<const UClass*, FRbsItemClassBucket> Buckets;
+
+	//Clients may hold a new quantity whose OnRep hasn't run yet, the server always applies it right away
+	const bool bHasAuthority = GetOwnerRole() == ROLE_Authority;
+
+	//Only count what is accounted, clients get the remove callback before the entry leaves the array
+	for (const FRbsInventoryEntry& Entry : Items.Entries)
+	{
+		if (!IsValid(Entry.Item) || Entry.Item->OwningInventory != this)
+			continue;
+
+		const int32 Quantity = bHasAuthority ? Entry.Item->Quantity : Entry.Item->AccountedQuantity;
+		FRbsItemClassBucket& Bucket = Buckets.FindOrAdd(Entry.Item->GetClass());
+		Bucket.Quantity += Quantity;
+		Bucket.Stacks.Add(Entry.Item);
+		Weight += Quantity * Entry.Item->Weight;
+		StackCount++;
+	}
+
+	TMap<const URbsItemDefinition*, int32> Definitions;
+	for (const FRbsItemInstance& Instance : ItemInstances.Entries)
+	{
+		if (!Instance.bCounted)
+			continue;
+
+		StackCount++;
+		const URbsItemDefinition* Definition = bHasAuthority ? Instance.Definition.Get() : Instance.AccountedDefinition;
+		const int32 Quantity = bHasAuthority ? Instance.Quantity : Instance.AccountedQuantity;
+		if (Definition && Quantity != 0)
+		{
+			Definitions.FindOrAdd(Definition) += Quantity;
+			Weight += Quantity * Definition->Weight;
+		}
+	}
+
+	ensureMsgf(FMath::IsNearlyEqual(Weight, CachedWeight, 1e-3), TEXT("%s cached weight %f doesn't match %f"), *GetPathName(), CachedWeight, Weight);
+	ensureMsgf(StackCount == CachedStackCount, TEXT("%s cached stack count %d doesn't match %d"), *GetPathName(), CachedStackCount, StackCount);
+	ensureMsgf(Buckets.Num() == ClassBuckets.Num(), TEXT("%s tracks %d item classes instead of %d"), *GetPathName(), ClassBuckets.Num(), Buckets.Num());
+	for (const TPair<const UClass*, FRbsItemClassBucket>& Pair : Buckets)
+	{
+		const FRbsItemClassBucket* Cached = ClassBuckets.Find(Pair.Key);
+		ensureMsgf(Cached && Cached->Quantity == Pair.Value.Quantity && Cached->Stacks.Num() == Pair.Value.Stacks.Num(),
+			TEXT("%s cached totals for %s are out of date"), *GetPathName(), *GetNameSafe(Pair.Key));
+	}
+
+	ensureMsgf(Definitions.Num() == DefinitionQuantities.Num(), TEXT("%s tracks %d item definitions instead of %d"), *GetPathName(), DefinitionQuantities.Num(), Definitions.Num());
+	for (const TPair<const URbsItemDefinition*, int32>& Pair : Definitions)
+	{
+		ensureMsgf(DefinitionQuantities.FindRef(Pair.Key) == Pair.Value, TEXT("%s cached quantity of %s is out of date"), *GetPathName(), *GetNameSafe(Pair.Key));
+	}
+}
+#endif
+
+void URbsInventoryComponent::ClientRefreshInventory_Implementation()
+{
+	BroadcastInventoryUpdated();
+}
+
+/*
+ * Update scope
+ */
+
+FRbsInventoryUpdateScope::FRbsInventoryUpdateScope(URbsInventoryComponent* InInventory)
+	: Inventory(InInventory)
+{
+	if (Inventory.IsValid())
+	{
+		Inventory->BeginUpdateBatch();
+	}
+}
+
+FRbsInventoryUpdateScope::~FRbsInventoryUpdateScope()
+{
+	if (Inventory.IsValid())
+	{
+		Inventory->EndUpdateBatch();
+	}
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,265 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Core/RbsInventoryConstraint.h"
+
+#include "Core/RbsInventoryItem.h"
+
+#define LOCTEXT_NAMESPACE "Inventory"
+
+namespace RbsInventoryConstraint
+{
+	//How many items of Size fit in Remaining, MAX_int32 for items that take none
+	int32 GetMaxAddableBySize(const double Remaining, const float Size)
+	{
+		if (Size <= 0.f)
+			return MAX_int32;
+
+		return static_cast<int32>(FMath::Clamp(FMath::FloorToDouble(Remaining / Size), 0.0, double(MAX_int32)));
+	}
+
+	int32 ToMaxAddable(const double Headroom)
+	{
+		return static_cast<int32>(FMath::Clamp(Headroom, 0.0, double(MAX_int32)));
+	}
+}
+
+URbsInventoryConstraint::URbsInventoryConstraint()
+{
+	FailureText = LOCTEXT("InventoryCapacityFullText", "Inventory Is Full");
+}
+
+/*
+ * Weight
+ */
+
+URbsWeightConstraint::URbsWeightConstraint()
+{
+	FailureText = LOCTEXT("InventoryTooMuchWeightText", "Too Much Weight");
+}
+
+int32 URbsWeightConstraint::GetMaxAddable(const URbsInventoryItem* Item) const
+{
+	return RbsInventoryConstraint::GetMaxAddableBySize(MaxWeight - CurrentWeight, Item->Weight);
+}
+
+void URbsWeightConstraint::AddQuantity(const URbsInventoryItem* Item, const int32 Delta)
+{
+	CurrentWeight += Delta * Item->Weight;
+}
+
+void URbsWeightConstraint::GetHeadroom(TArray<double>& OutHeadroom) const
+{
+	OutHeadroom.Add(MaxWeight - CurrentWeight);
+}
+
+int32 URbsWeightConstraint::GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const
+{
+	return RbsInventoryConstraint::GetMaxAddableBySize(Headroom[0], Item->Weight);
+}
+
+void URbsWeightConstraint::SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const
+{
+	Headroom[0] -= Quantity * Item->Weight;
+}
+
+/*
+ * Volume
+ */
+
+URbsVolumeConstraint::URbsVolumeConstraint()
+{
+	FailureText = LOCTEXT("InventoryTooMuchVolumeText", "Not Enough Room");
+}
+
+int32 URbsVolumeConstraint::GetMaxAddable(const URbsInventoryItem* Item) const
+{
+	return RbsInventoryConstraint::GetMaxAddableBySize(MaxVolume - CurrentVolume, Item->Volume);
+}
+
+void URbsVolumeConstraint::AddQuantity(const URbsInventoryItem* Item, const int32 Delta)
+{
+	CurrentVolume += Delta * Item->Volume;
+}
+
+void URbsVolumeConstraint::GetHeadroom(TArray<double>& OutHeadroom) const
+{
+	OutHeadroom.Add(MaxVolume - CurrentVolume);
+}
+
+int32 URbsVolumeConstraint::GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const
+{
+	return RbsInventoryConstraint::GetMaxAddableBySize(Headroom[0], Item->Volume);
+}
+
+void URbsVolumeConstraint::SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const
+{
+	Headroom[0] -= Quantity * Item->Volume;
+}
+
+/*
+ * Category
+ */
+
+URbsCategoryConstraint::URbsCategoryConstraint()
+{
+	FailureText = LOCTEXT("InventoryCategoryLimitText", "Can't Carry More Of These");
+}
+
+int32 URbsCategoryConstraint::GetMaxAddable(const URbsInventoryItem* Item) const
+{
+	const int32 LimitIndex = FindLimit(Item->GetClass());
+	if (LimitIndex == INDEX_NONE)
+		return MAX_int32;
+
+	const int32 Quantity = Quantities.IsValidIndex(LimitIndex) ? Quantities[LimitIndex] : 0;
+	return FMath::Max(Limits[LimitIndex].MaxQuantity - Quantity, 0);
+}
+
+void URbsCategoryConstraint::AddQuantity(const URbsInventoryItem* Item, const int32 Delta)
+{
+	const int32 LimitIndex = FindLimit(Item->GetClass());
+	if (LimitIndex == INDEX_NONE)
+		return;
+
+	if (!Quantities.IsValidIndex(LimitIndex))
+	{
+		Quantities.SetNumZeroed(Limits.Num());
+	}
+	Quantities[LimitIndex] += Delta;
+}
+
+void URbsCategoryConstraint::ResetAggregates()
+{
+	ClassLimits.Reset();
+	Quantities.Reset();
+	Quantities.SetNumZeroed(Limits.Num());
+}
+
+void URbsCategoryConstraint::GetHeadroom(TArray<double>& OutHeadroom) const
+{
+	for (int32 LimitIndex = 0; LimitIndex < Limits.Num(); LimitIndex++)
+	{
+		OutHeadroom.Add(Limits[LimitIndex].MaxQuantity - (Quantities.IsValidIndex(LimitIndex) ? Quantities[LimitIndex] : 0));
+	}
+}
+
+int32 URbsCategoryConstraint::GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const
+{
+	const int32 LimitIndex = FindLimit(Item->GetClass());
+	return LimitIndex != INDEX_NONE ? RbsInventoryConstraint::ToMaxAddable(Headroom[LimitIndex]) : MAX_int32;
+}
+
+void URbsCategoryConstraint::SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const
+{
+	const int32 LimitIndex = FindLimit(Item->GetClass());
+	if (LimitIndex != INDEX_NONE)
+	{
+		Headroom[LimitIndex] -= Quantity;
+	}
+}
+
+int32 URbsCategoryConstraint::FindLimit(const UClass* ItemClass) const
+{
+	if (const int32* Found = ClassLimits.Find(ItemClass))
+		return *Found;
+
+	const FString Category = ItemClass->GetDefaultObject<URbsInventoryItem>()->Category.BuildSourceString();
+	const int32 LimitIndex = Limits.IndexOfByPredicate([&Category](const FRbsCategoryLimit& Limit)
+	{
+		return Limit.Category.BuildSourceString() == Category;
+	});
+
+	ClassLimits.Add(ItemClass, LimitIndex);
+	return LimitIndex;
+}
+
+/*
+ * Class
+ */
+
+URbsClassConstraint::URbsClassConstraint()
+{
+	FailureText = LOCTEXT("InventoryClassLimitText", "Can't Carry More Of These");
+}
+
+int32 URbsClassConstraint::GetMaxAddable(const URbsInventoryItem* Item) const
+{
+	int32 MaxAddable = MAX_int32;
+	for (const int32 LimitIndex : FindLimits(Item->GetClass()))
+	{
+		const int32 Quantity = Quantities.IsValidIndex(LimitIndex) ? Quantities[LimitIndex] : 0;
+		MaxAddable = FMath::Min(MaxAddable, FMath::Max(Limits[LimitIndex].MaxQuantity - Quantity, 0));
+	}
+
+	return MaxAddable;
+}
+
+void URbsClassConstraint::AddQuantity(const URbsInventoryItem* Item, const int32 Delta)
+{
+	const TArray<int32, TInlineAllocator<2>> LimitIndices = FindLimits(Item->GetClass());
+	if (LimitIndices.Num() == 0)
+		return;
+
+	if (Quantities.Num() < Limits.Num())
+	{
+		Quantities.SetNumZeroed(Limits.Num());
+	}
+
+	for (const int32 LimitIndex : LimitIndices)
+	{
+		Quantities[LimitIndex] += Delta;
+	}
+}
+
+void URbsClassConstraint::ResetAggregates()
+{
+	ClassLimits.Reset();
+	Quantities.Reset();
+	Quantities.SetNumZeroed(Limits.Num());
+}
+
+void URbsClassConstraint::GetHeadroom(TArray<double>& OutHeadroom) const
+{
+	for (int32 LimitIndex = 0; LimitIndex < Limits.Num(); LimitIndex++)
+	{
+		OutHeadroom.Add(Limits[LimitIndex].MaxQuantity - (Quantities.IsValidIndex(LimitIndex) ? Quantities[LimitIndex] : 0));
+	}
+}
+
+int32 URbsClassConstraint::GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const
+{
+	int32 MaxAddable = MAX_int32;
+	for (const int32 LimitIndex : FindLimits(Item->GetClass()))
+	{
+		MaxAddable = FMath::Min(MaxAddable, RbsInventoryConstraint::ToMaxAddable(Headroom[LimitIndex]));
+	}
+
+	return MaxAddable;
+}
+
+void URbsClassConstraint::SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const
+{
+	for (const int32 LimitIndex : FindLimits(Item->GetClass()))
+	{
+		Headroom[LimitIndex] -= Quantity;
+	}
+}
+
+TArray<int32, TInlineAllocator<2>> URbsClassConstraint::FindLimits(const UClass* ItemClass) const
+{
+	if (const TArray<int32, TInlineAllocator<2>>* Found = ClassLimits.Find(ItemClass))
+		return *Found;
+
+	TArray<int32, TInlineAllocator<2>>& LimitIndices = ClassLimits.Add(ItemClass);
+	for (int32 LimitIndex = 0; LimitIndex < Limits.Num(); LimitIndex++)
+	{
+		if (Limits[LimitIndex].ItemClass && ItemClass->IsChildOf(Limits[LimitIndex].ItemClass))
+		{
+			LimitIndices.Add(LimitIndex);
+		}
+	}
+
+	return LimitIndices;
+}
+
+#undef LOCTEXT_NAMESPACE
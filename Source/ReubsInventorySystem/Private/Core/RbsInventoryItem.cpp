@@ -4,6 +4,7 @@
 
 #include "Core/RbsInventoryComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 #define LOCTEXT_NAMESPACE "Item"
 
@@ -42,7 +43,10 @@ void URbsInventoryItem::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& Ou
 {
 	UObject::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(URbsInventoryItem, Quantity);
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = RBS_WITH_PUSH_MODEL;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(URbsInventoryItem, Quantity, Params);
 }
 
 void URbsInventoryItem::MarkDirtyForReplication()
@@ -51,12 +55,20 @@ void URbsInventoryItem::MarkDirtyForReplication()
 
 	if (IsValid(OwningInventory))
 	{
-		OwningInventory->ReplicatedItemsKey++;
+		OwningInventory->MarkSubobjectsDirty();
 	}
 }
 
 void URbsInventoryItem::OnRep_Quantity()
 {
+	if (IsValid(OwningInventory))
+	{
+		OwningInventory->HandleItemQuantityChanged(this);
+
+		if (OwningInventory->DeferItemModified(this))
+			return;
+	}
+
 	OnItemModified.Broadcast();
 }
 
@@ -68,15 +80,47 @@ void URbsInventoryItem::AddedToInventory_Implementation(URbsInventoryComponent*
 {
 }
 
+void URbsInventoryItem::OnRecycled_Implementation()
+{
+}
+
+void URbsInventoryItem::ResetForReuse()
+{
+	//Whoever listened to the old stack must not hear about the next one
+	OnItemModified.Clear();
+	bPendingModifiedBroadcast = false;
+	AccountedQuantity = 0;
+	OwningInventory = nullptr;
+	Handle = FRbsItemHandle();
+	EntryOrder = 0;
+	PredictedQuantityDelta = 0;
+
+	//Goes through SetQuantity so the change is marked dirty, the next stack must replicate its own quantity
+	SetQuantity(GetClass()->GetDefaultObject<URbsInventoryItem>()->Quantity);
+
+	OnRecycled();
+}
+
 void URbsInventoryItem::SetQuantity(const int32 NewQuantity)
 {
 	if (NewQuantity != Quantity)
 	{
 		Quantity = NewQuantity;
 			//FMath::Clamp(NewQuantity, 0, bStackable ? MaxStackSize : 1);
+		MARK_PROPERTY_DIRTY_FROM_NAME(URbsInventoryItem, Quantity, this);
 		OnRep_Quantity();
 		MarkDirtyForReplication();
 	}
 }
 
+UTexture2D* URbsInventoryItem::GetThumbnail() const
+{
+	return Thumbnail ? Thumbnail : SoftThumbnail.Get();
+}
+
+TSubclassOf<AActor> URbsInventoryItem::GetPickupClass() const
+{
+	return PickupClass ? PickupClass : TSubclassOf<AActor>(SoftPickupClass.Get());
+}
+
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,298 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Core/RbsInventoryList.h"
+
+#include "Algo/IsSorted.h"
+#include "Algo/Sort.h"
+#include "Core/RbsInventoryComponent.h"
+#include "Engine/PackageMapClient.h"
+
+namespace RbsInventoryList
+{
+	//Skipping the write keeps the connection's last state, a connection allowed in later gets everything it missed
+	bool ShouldSkipWrite(const FNetDeltaSerializeInfo& DeltaParms, const URbsInventoryComponent* OwnerComponent)
+	{
+		if (!DeltaParms.Writer || !IsValid(OwnerComponent))
+			return false;
+
+		const UPackageMapClient* PackageMap = Cast<UPackageMapClient>(DeltaParms.Map);
+		return PackageMap && !OwnerComponent->CanReceiveDetail(PackageMap->GetConnection());
+	}
+}
+
+/*
+ * Client callbacks
+ */
+
+void FRbsInventoryEntry::PreReplicatedRemove(const FRbsInventoryList& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.OwnerComponent))
+	{
+		InArraySerializer.OwnerComponent->HandleEntryRemoved(Item);
+	}
+}
+
+void FRbsInventoryEntry::PostReplicatedAdd(const FRbsInventoryList& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.OwnerComponent))
+	{
+		InArraySerializer.OwnerComponent->HandleEntryAdded(Item, Handle);
+	}
+}
+
+void FRbsInventoryEntry::PostReplicatedChange(const FRbsInventoryList& InArraySerializer)
+{
+	//The item reference may only resolve after the entry itself was added
+	if (IsValid(InArraySerializer.OwnerComponent))
+	{
+		InArraySerializer.OwnerComponent->HandleEntryAdded(Item, Handle);
+	}
+}
+
+/*
+ * Behaviour
+ */
+
+void FRbsInventoryList::AddEntry(URbsInventoryItem* Item, const FRbsItemHandle& Handle, const FRbsGridPlacement& GridPlacement)
+{
+	//Out of orders after the end, space the existing entries out again. Takes millions of adds
+	if (Entries.Num() > 0 && Entries.Last().Order > MAX_int32 - OrderStride)
+	{
+		for (int32 Index = 0; Index < Entries.Num(); Index++)
+		{
+			Entries[Index].Order = Index * OrderStride;
+			MarkItemDirty(Entries[Index]);
+		}
+
+		if (IsValid(OwnerComponent))
+		{
+			OwnerComponent->HandleEntriesReordered();
+		}
+	}
+
+	FRbsInventoryEntry& Entry = Entries.Emplace_GetRef(Item, Handle, GridPlacement);
+	Entry.Order = Entries.Num() > 1 ? Entries.Last(1).Order + OrderStride : 0;
+	MarkItemDirty(Entry);
+}
+
+bool FRbsInventoryList::RemoveEntry(const URbsInventoryItem* Item)
+{
+	const int32 Index = IndexOf(Item);
+	if (Index == INDEX_NONE)
+		return false;
+
+	//Keep the order stable, the orders of the other entries don't change
+	Entries.RemoveAt(Index);
+	MarkArrayDirty();
+
+	return true;
+}
+
+void FRbsInventoryList::MoveEntry(const int32 FromIndex, const int32 ToIndex)
+{
+	if (FromIndex == ToIndex)
+		return;
+
+	//The orders of the entries the move shifts, in case the moved one doesn't fit between its new neighbours
+	const int32 FirstIndex = FMath::Min(FromIndex, ToIndex);
+	const int32 LastIndex = FMath::Max(FromIndex, ToIndex);
+	TArray<int32, TInlineAllocator<16>> RangeOrders;
+	for (int32 Index = FirstIndex; Index <= LastIndex; Index++)
+	{
+		RangeOrders.Add(Entries[Index].Order);
+	}
+
+	FRbsInventoryEntry Entry = MoveTemp(Entries[FromIndex]);
+	Entries.RemoveAt(FromIndex);
+	Entries.Insert(MoveTemp(Entry), ToIndex);
+
+	const int64 Lower = ToIndex > 0 ? int64(Entries[ToIndex - 1].Order) : int64(MIN_int32);
+	const int64 Upper = ToIndex + 1 < Entries.Num() ? int64(Entries[ToIndex + 1].Order) : int64(MAX_int32);
+	if (Upper - Lower > 1)
+	{
+		//Stay a stride away from the neighbour at either end of the list, so the next move there still has room
+		int64 NewOrder = (Lower + Upper) / 2;
+		if (ToIndex == 0)
+		{
+			NewOrder = FMath::Max(Upper - OrderStride, NewOrder);
+		}
+		else if (ToIndex + 1 == Entries.Num())
+		{
+			NewOrder = FMath::Min(Lower + OrderStride, NewOrder);
+		}
+
+		Entries[ToIndex].Order = static_cast<int32>(NewOrder);
+		MarkItemDirty(Entries[ToIndex]);
+	}
+	else
+	{
+		AssignOrders(FirstIndex, RangeOrders);
+	}
+
+	if (IsValid(OwnerComponent))
+	{
+		OwnerComponent->HandleEntriesReordered();
+	}
+}
+
+void FRbsInventoryList::ReorderEntries(TConstArrayView<int32> NewOrder)
+{
+	check(NewOrder.Num() == Entries.Num());
+
+	int32 FirstMoved = 0;
+	while (FirstMoved < NewOrder.Num() && NewOrder[FirstMoved] == FirstMoved)
+	{
+		FirstMoved++;
+	}
+
+	if (FirstMoved == NewOrder.Num())
+		return;
+
+	TArray<int32> SortedOrders;
+	SortedOrders.Reserve(Entries.Num() - FirstMoved);
+	for (int32 Index = FirstMoved; Index < Entries.Num(); Index++)
+	{
+		SortedOrders.Add(Entries[Index].Order);
+	}
+
+	TArray<FRbsInventoryEntry> Reordered;
+	Reordered.Reserve(Entries.Num());
+	for (const int32 Index : NewOrder)
+	{
+		Reordered.Add(MoveTemp(Entries[Index]));
+	}
+	Entries = MoveTemp(Reordered);
+
+	AssignOrders(FirstMoved, SortedOrders);
+
+	if (IsValid(OwnerComponent))
+	{
+		OwnerComponent->HandleEntriesReordered();
+	}
+}
+
+void FRbsInventoryList::AssignOrders(const int32 FirstIndex, TConstArrayView<int32> SortedOrders)
+{
+	for (int32 i = 0; i < SortedOrders.Num(); i++)
+	{
+		FRbsInventoryEntry& Entry = Entries[FirstIndex + i];
+		if (Entry.Order != SortedOrders[i])
+		{
+			Entry.Order = SortedOrders[i];
+			MarkItemDirty(Entry);
+		}
+	}
+}
+
+/*
+ * Replication
+ */
+
+bool FRbsInventoryList::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	if (RbsInventoryList::ShouldSkipWrite(DeltaParms, OwnerComponent))
+		return false;
+
+	return FFastArraySerializer::FastArrayDeltaSerialize<FRbsInventoryEntry, FRbsInventoryList>(Entries, DeltaParms, *this);
+}
+
+void FRbsInventoryList::PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters)
+{
+	//Removals are applied with a swap on clients, restore the server order
+	if (!Algo::IsSortedBy(Entries, &FRbsInventoryEntry::Order))
+	{
+		Algo::SortBy(Entries, &FRbsInventoryEntry::Order);
+		ItemMap.Reset();
+	}
+
+	//Placements may arrive in any order within the update, so the grid is rebuilt once all of them are in
+	if (IsValid(OwnerComponent))
+	{
+		OwnerComponent->HandleEntriesReordered();
+		OwnerComponent->RebuildGrid();
+	}
+}
+
+/*
+ * Helpers
+ */
+
+int32 FRbsInventoryList::IndexOf(const URbsInventoryItem* Item) const
+{
+	return Entries.IndexOfByPredicate([Item](const FRbsInventoryEntry& Entry) { return Entry.Item == Item; });
+}
+
+/*
+ * Item instances
+ */
+
+float FRbsItemInstance::GetValue(const FName Name, const float DefaultValue) const
+{
+	const FRbsItemInstanceValue* Found = Payload.FindByPredicate([Name](const FRbsItemInstanceValue& Entry) { return Entry.Name == Name; });
+	return Found ? Found->Value : DefaultValue;
+}
+
+void FRbsItemInstance::SetValue(const FName Name, const float Value)
+{
+	if (FRbsItemInstanceValue* Found = Payload.FindByPredicate([Name](const FRbsItemInstanceValue& Entry) { return Entry.Name == Name; }))
+	{
+		Found->Value = Value;
+		return;
+	}
+
+	Payload.Add({ Name, Value });
+}
+
+void FRbsItemInstance::PreReplicatedRemove(const FRbsItemInstanceList& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.OwnerComponent))
+	{
+		InArraySerializer.OwnerComponent->HandleInstanceRemoved(*this);
+	}
+}
+
+void FRbsItemInstance::PostReplicatedAdd(const FRbsItemInstanceList& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.OwnerComponent))
+	{
+		InArraySerializer.OwnerComponent->HandleInstanceAdded(*this);
+	}
+}
+
+void FRbsItemInstance::PostReplicatedChange(const FRbsItemInstanceList& InArraySerializer)
+{
+	if (IsValid(InArraySerializer.OwnerComponent))
+	{
+		InArraySerializer.OwnerComponent->HandleInstanceChanged(*this);
+	}
+}
+
+FRbsItemInstance& FRbsItemInstanceList::AddInstance(const URbsItemDefinition* Definition, const int32 Quantity)
+{
+	FRbsItemInstance& Instance = Entries.Emplace_GetRef(Definition, Quantity);
+	MarkItemDirty(Instance);
+	return Instance;
+}
+
+void FRbsItemInstanceList::RemoveInstanceAt(const int32 Index)
+{
+	Entries.RemoveAt(Index);
+	MarkArrayDirty();
+}
+
+bool FRbsItemInstanceList::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	if (RbsInventoryList::ShouldSkipWrite(DeltaParms, OwnerComponent))
+		return false;
+
+	return FFastArraySerializer::FastArrayDeltaSerialize<FRbsItemInstance, FRbsItemInstanceList>(Entries, DeltaParms, *this);
+}
+
+void FRbsItemInstanceList::PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters)
+{
+	if (!Algo::IsSortedBy(Entries, &FRbsItemInstance::ReplicationID))
+	{
+		Algo::SortBy(Entries, &FRbsItemInstance::ReplicationID);
+		ItemMap.Reset();
+	}
+}
@@ -0,0 +1,18 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Core/RbsItemDefinition.h"
+
+#define LOCTEXT_NAMESPACE "Item"
+
+URbsItemDefinition::URbsItemDefinition()
+{
+	DisplayName = LOCTEXT("Placeholder Name", "Item");
+	Description = LOCTEXT("Placeholder Description", "Item");
+}
+
+FPrimaryAssetId URbsItemDefinition::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(TEXT("RbsItemDefinition"), GetFName());
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,102 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Core/RbsItemPoolSubsystem.h"
+
+#include "Core/RbsInventoryItem.h"
+#include "ReubsInventorySystem.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Item pool hits"), STAT_RbsItemPool_Hits, STATGROUP_RbsInventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Item pool misses"), STAT_RbsItemPool_Misses, STATGROUP_RbsInventory);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled items"), STAT_RbsItemPool_Pooled, STATGROUP_RbsInventory);
+
+/*
+ * Behaviour
+ */
+
+URbsInventoryItem* URbsItemPoolSubsystem::AcquireItem(TSubclassOf<URbsInventoryItem> ItemClass, UObject* Outer)
+{
+	if (TArray<TObjectPtr<URbsInventoryItem>>* Pool = Pools.Find(FPoolKey(Outer, ItemClass.Get())))
+	{
+		while (Pool->Num() > 0)
+		{
+			URbsInventoryItem* Item = Pool->Pop();
+			Stats.Pooled--;
+			DEC_DWORD_STAT(STAT_RbsItemPool_Pooled);
+
+			if (IsValid(Item))
+			{
+				Stats.Hits++;
+				INC_DWORD_STAT(STAT_RbsItemPool_Hits);
+				return Item;
+			}
+		}
+	}
+
+	Stats.Misses++;
+	INC_DWORD_STAT(STAT_RbsItemPool_Misses);
+
+	return NewObject<URbsInventoryItem>(Outer, ItemClass);
+}
+
+void URbsItemPoolSubsystem::ReleaseItem(URbsInventoryItem* Item)
+{
+	if (!IsValid(Item) || !ensure(!IsValid(Item->GetOwningInventory())))
+		return;
+
+	TArray<TObjectPtr<URbsInventoryItem>>& Pool = Pools.FindOrAdd(FPoolKey(Item->GetOuter(), Item->GetClass()));
+	if (Pool.Num() >= MaxPooledPerClass)
+	{
+		Stats.Discarded++;
+		return;
+	}
+
+	Item->ResetForReuse();
+	Pool.Add(Item);
+
+	Stats.Recycled++;
+	Stats.Pooled++;
+	INC_DWORD_STAT(STAT_RbsItemPool_Pooled);
+}
+
+void URbsItemPoolSubsystem::ReleaseOuter(const UObject* Outer)
+{
+	const FObjectKey OuterKey(Outer);
+	for (auto It = Pools.CreateIterator(); It; ++It)
+	{
+		if (It.Key().Key == OuterKey)
+		{
+			Stats.Pooled -= It.Value().Num();
+			DEC_DWORD_STAT_BY(STAT_RbsItemPool_Pooled, It.Value().Num());
+			It.RemoveCurrent();
+		}
+	}
+}
+
+/*
+ * Helpers
+ */
+
+void URbsItemPoolSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_RbsItemPool_Pooled, Stats.Pooled);
+	Pools.Empty();
+	Stats.Pooled = 0;
+
+	Super::Deinitialize();
+}
+
+void URbsItemPoolSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+
+	URbsItemPoolSubsystem* This = CastChecked<URbsItemPoolSubsystem>(InThis);
+	for (TPair<FPoolKey, TArray<TObjectPtr<URbsInventoryItem>>>& Pair : This->Pools)
+	{
+		Collector.AddReferencedObjects(Pair.Value, This);
+	}
+}
+
+bool URbsItemPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
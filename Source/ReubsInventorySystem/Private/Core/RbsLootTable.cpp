@@ -0,0 +1,248 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Core/RbsLootTable.h"
+
+#include "Async/ParallelFor.h"
+
+namespace RbsLootTable
+{
+	//Tables nested deeper than this stop rolling, so a table nested in itself can't loop forever
+	constexpr int32 MaxNestingDepth = 8;
+
+	//Entries rolled at most per roll of a table, with its nested tables
+	constexpr int32 MaxRolls = 4096;
+}
+
+struct URbsLootTable::FRollState
+{
+	FRollState(FRandomStream& InStream, TArray<FItemSpec>& InSpecs)
+		: Stream(InStream)
+		, Specs(InSpecs)
+	{
+		for (int32 Index = 0; Index < Specs.Num(); Index++)
+		{
+			SpecIndices.Add(Specs[Index].ItemClass.Get(), Index);
+		}
+	}
+
+	FRandomStream& Stream;
+	TArray<FItemSpec>& Specs;
+
+	//Index in Specs of each class, so several picks of the same class become one spec
+	TMap<const UClass*, int32> SpecIndices;
+
+	int32 RollsLeft = RbsLootTable::MaxRolls;
+};
+
+void URbsLootTable::PostLoad()
+{
+	Super::PostLoad();
+
+	bSamplerBuilt = false;
+	BuildSampler();
+}
+
+#if WITH_EDITOR
+
+void URbsLootTable::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	MaxPicks = FMath::Max(MinPicks, MaxPicks);
+	bSamplerBuilt = false;
+	BuildSampler();
+}
+
+#endif
+
+/*
+ * Behaviour
+ */
+
+void URbsLootTable::RollLoot(FRandomStream& Stream, TArray<FItemSpec>& OutSpecs) const
+{
+	check(IsInGameThread() || bSamplerBuilt);
+
+	BuildSampler();
+
+	FRollState State(Stream, OutSpecs);
+	RollLoot_Internal(State, 0, 1);
+}
+
+TArray<FItemSpec> URbsLootTable::RollLootFromSeed(const int32 Seed) const
+{
+	FRandomStream Stream(Seed);
+	TArray<FItemSpec> Specs;
+	RollLoot(Stream, Specs);
+
+	return Specs;
+}
+
+void URbsLootTable::RollLootBatch(TConstArrayView<const URbsLootTable*> Tables, TConstArrayView<int32> Seeds, TArray<TArray<FItemSpec>>& OutSpecs)
+{
+	check(Tables.Num() == Seeds.Num());
+
+	//Samplers are built lazily, do it here so the workers only ever read them
+	for (const URbsLootTable* Table : Tables)
+	{
+		if (Table)
+		{
+			Table->BuildSampler();
+		}
+	}
+
+	OutSpecs.Reset();
+	OutSpecs.SetNum(Tables.Num());
+
+	ParallelFor(Tables.Num(), [&Tables, &Seeds, &OutSpecs](const int32 Index)
+	{
+		if (!Tables[Index])
+			return;
+
+		FRandomStream Stream(Seeds[Index]);
+		FRollState State(Stream, OutSpecs[Index]);
+		Tables[Index]->RollLoot_Internal(State, 0, 1);
+	});
+}
+
+void URbsLootTable::BuildSampler() const
+{
+	if (bSamplerBuilt)
+		return;
+
+	//Set first, so a table nested in itself doesn't build forever
+	bSamplerBuilt = true;
+
+	const int32 Count = Entries.Num();
+	PickProbabilities.Reset(Count);
+	PickAliases.Reset(Count);
+	PickProbabilities.AddZeroed(Count);
+	PickAliases.AddZeroed(Count);
+
+	double TotalWeight = 0.0;
+	for (const FRbsLootEntry& Entry : Entries)
+	{
+		TotalWeight += FMath::Max(Entry.Weight, 0.f);
+	}
+
+	if (TotalWeight <= 0.0)
+	{
+		//Nothing can be picked
+		PickProbabilities.Reset();
+		PickAliases.Reset();
+	}
+	else
+	{
+		//Scale the weights so the average column is 1, then fill the short columns from the tall ones
+		TArray<double> Scaled;
+		Scaled.SetNumUninitialized(Count);
+
+		TArray<int32> Small;
+		TArray<int32> Large;
+		for (int32 i = 0; i < Count; i++)
+		{
+			Scaled[i] = FMath::Max(Entries[i].Weight, 0.f) * Count / TotalWeight;
+			(Scaled[i] < 1.0 ? Small : Large).Add(i);
+		}
+
+		while (Small.Num() > 0 && Large.Num() > 0)
+		{
+			const int32 Short = Small.Pop(EAllowShrinking::No);
+			const int32 Tall = Large.Pop(EAllowShrinking::No);
+
+			PickProbabilities[Short] = static_cast<float>(Scaled[Short]);
+			PickAliases[Short] = Tall;
+
+			Scaled[Tall] = Scaled[Tall] + Scaled[Short] - 1.0;
+			(Scaled[Tall] < 1.0 ? Small : Large).Add(Tall);
+		}
+
+		//Whatever is left is 1 give or take rounding errors
+		for (const int32 Index : Large)
+		{
+			PickProbabilities[Index] = 1.f;
+			PickAliases[Index] = Index;
+		}
+
+		for (const int32 Index : Small)
+		{
+			PickProbabilities[Index] = 1.f;
+			PickAliases[Index] = Index;
+		}
+	}
+
+	auto BuildNested = [](const TArray<FRbsLootEntry>& NestedEntries)
+	{
+		for (const FRbsLootEntry& Entry : NestedEntries)
+		{
+			if (Entry.NestedTable)
+			{
+				Entry.NestedTable->BuildSampler();
+			}
+		}
+	};
+
+	BuildNested(GuaranteedEntries);
+	BuildNested(Entries);
+}
+
+/*
+ * Helpers
+ */
+
+void URbsLootTable::RollLoot_Internal(FRollState& State, const int32 Depth, const int64 Multiplier) const
+{
+	if (Depth >= RbsLootTable::MaxNestingDepth)
+		return;
+
+	for (const FRbsLootEntry& Entry : GuaranteedEntries)
+	{
+		RollEntry(Entry, State, Depth, Multiplier);
+	}
+
+	if (PickProbabilities.Num() == 0)
+		return;
+
+	const int32 Picks = State.Stream.RandRange(MinPicks, FMath::Max(MinPicks, MaxPicks));
+	for (int32 i = 0; i < Picks; i++)
+	{
+		RollEntry(Entries[PickEntry(State.Stream)], State, Depth, Multiplier);
+	}
+}
+
+void URbsLootTable::RollEntry(const FRbsLootEntry& Entry, FRollState& State, const int32 Depth, const int64 Multiplier) const
+{
+	if (State.RollsLeft <= 0)
+		return;
+
+	State.RollsLeft--;
+
+	//Always roll the quantity, so an empty entry never shifts the rolls of the next ones
+	const int32 Quantity = State.Stream.RandRange(Entry.MinQuantity, FMath::Max(Entry.MinQuantity, Entry.MaxQuantity));
+	const int64 ScaledQuantity = FMath::Min<int64>(Multiplier * Quantity, MAX_int32);
+
+	if (Entry.NestedTable)
+	{
+		//Rolled once and scaled, rolling it once per unit would grow with the quantity to the power of the nesting depth
+		Entry.NestedTable->RollLoot_Internal(State, Depth + 1, ScaledQuantity);
+	}
+	else if (Entry.ItemClass)
+	{
+		if (const int32* SpecIndex = State.SpecIndices.Find(Entry.ItemClass.Get()))
+		{
+			FItemSpec& Spec = State.Specs[*SpecIndex];
+			Spec.Quantity = static_cast<int32>(FMath::Min<int64>(Spec.Quantity + ScaledQuantity, MAX_int32));
+		}
+		else
+		{
+			State.SpecIndices.Add(Entry.ItemClass.Get(), State.Specs.Emplace(Entry.ItemClass, static_cast<int32>(ScaledQuantity)));
+		}
+	}
+}
+
+int32 URbsLootTable::PickEntry(FRandomStream& Stream) const
+{
+	const int32 Column = Stream.RandHelper(PickProbabilities.Num());
+
+	return Stream.FRand() < PickProbabilities[Column] ? Column : PickAliases[Column];
+}
@@ -0,0 +1,128 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Core/RbsPickupPoolSubsystem.h"
+
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Utils/RbsPickupInterface.h"
+
+/*
+ * Behaviour
+ */
+
+AActor* URbsPickupPoolSubsystem::AcquirePickup(UClass* PickupClass, const FTransform& SpawnTransform, AActor* Owner)
+{
+	if (TArray<TWeakObjectPtr<AActor>>* Pool = Pools.Find(PickupClass))
+	{
+		while (Pool->Num() > 0)
+		{
+			AActor* Pickup = Pool->Pop().Get();
+			if (!IsValid(Pickup))
+				continue;
+
+			Pickup->SetOwner(Owner);
+			Pickup->SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+			Pickup->SetNetDormancy(DORM_Awake);
+			IRbsPickupInterface::Execute_ReactivatePickup(Pickup);
+			Pickup->ForceNetUpdate();
+
+			return Pickup;
+		}
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = Owner;
+	SpawnParams.bNoFail = true;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	return GetWorld()->SpawnActor<AActor>(PickupClass, SpawnTransform, SpawnParams);
+}
+
+void URbsPickupPoolSubsystem::ReleasePickup(AActor* Pickup)
+{
+	if (!IsValid(Pickup) || !Pickup->HasAuthority())
+		return;
+
+	RecentDrops.RemoveAllSwap([Pickup](const FRecentDrop& Drop) { return Drop.Pickup == Pickup; });
+
+	TArray<TWeakObjectPtr<AActor>>& Pool = Pools.FindOrAdd(Pickup->GetClass());
+	Pool.RemoveAllSwap([](const TWeakObjectPtr<AActor>& Pooled) { return !Pooled.IsValid(); });
+	if (Pool.Contains(Pickup))
+		return;
+
+	if (Pool.Num() >= MaxPooledPerClass)
+	{
+		Pickup->Destroy();
+		return;
+	}
+
+	//The reset state goes out with the last update before the channel goes dormant
+	IRbsPickupInterface::Execute_ResetPickup(Pickup);
+	Pickup->SetOwner(nullptr);
+	Pickup->SetNetDormancy(DORM_DormantAll);
+	Pool.Add(Pickup);
+}
+
+void URbsPickupPoolSubsystem::RegisterDrop(AActor* Pickup)
+{
+	if (!IsValid(Pickup))
+		return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	RecentDrops.RemoveAllSwap([Pickup, Now, this](const FRecentDrop& Drop)
+	{
+		return Drop.Pickup == Pickup || !Drop.Pickup.IsValid() || Now - Drop.Time > RecentDropLifetime;
+	});
+
+	RecentDrops.Add({ Pickup, Pickup->GetClass(), Pickup->GetActorLocation(), Now });
+}
+
+AActor* URbsPickupPoolSubsystem::FindRecentDrop(const UClass* PickupClass, const FVector& Location, const float Radius, const float TimeWindow)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double RadiusSquared = FMath::Square(Radius);
+
+	AActor* Found = nullptr;
+	double FoundTime = 0.0;
+	for (const FRecentDrop& Drop : RecentDrops)
+	{
+		if (Drop.PickupClass != PickupClass || Now - Drop.Time > TimeWindow || Drop.Time < FoundTime)
+			continue;
+
+		if (FVector::DistSquared(Drop.Location, Location) > RadiusSquared || !Drop.Pickup.IsValid())
+			continue;
+
+		Found = Drop.Pickup.Get();
+		FoundTime = Drop.Time;
+	}
+
+	return Found;
+}
+
+/*
+ * Helpers
+ */
+
+int32 URbsPickupPoolSubsystem::GetPooledCount() const
+{
+	int32 Count = 0;
+	for (const TPair<const UClass*, TArray<TWeakObjectPtr<AActor>>>& Pair : Pools)
+	{
+		Count += Pair.Value.Num();
+	}
+
+	return Count;
+}
+
+void URbsPickupPoolSubsystem::Deinitialize()
+{
+	Pools.Empty();
+	RecentDrops.Empty();
+
+	Super::Deinitialize();
+}
+
+bool URbsPickupPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
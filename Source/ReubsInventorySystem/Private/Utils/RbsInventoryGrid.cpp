@@ -0,0 +1,97 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Utils/RbsInventoryGrid.h"
+
+void FRbsInventoryGrid::Init(const int32 InWidth, const int32 InHeight)
+{
+	Width = FMath::Clamp(InWidth, 0, MaxWidth);
+	Rows.Reset();
+	Rows.AddZeroed(FMath::Max(InHeight, 0));
+}
+
+void FRbsInventoryGrid::Reset()
+{
+	FMemory::Memzero(Rows.GetData(), Rows.Num() * sizeof(uint64));
+}
+
+bool FRbsInventoryGrid::IsFree(const FIntRect& Rect, const FIntRect& Ignored) const
+{
+	if (!IsInside(Rect))
+		return false;
+
+	const uint64 RectMask = MakeRowMask(Rect.Min.X, Rect.Width());
+	const uint64 IgnoredMask = Ignored.Area() > 0 ? MakeRowMask(Ignored.Min.X, Ignored.Width()) : 0;
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+	{
+		const uint64 Used = Y >= Ignored.Min.Y && Y < Ignored.Max.Y ? Rows[Y] & ~IgnoredMask : Rows[Y];
+		if (Used & RectMask)
+			return false;
+	}
+
+	return true;
+}
+
+bool FRbsInventoryGrid::FindSpace(const FIntPoint& Size, FIntPoint& OutPosition) const
+{
+	if (Size.X <= 0 || Size.Y <= 0 || Size.X > Width || Size.Y > Rows.Num())
+		return false;
+
+	//Only columns the item can start at without going past the right edge
+	const uint64 StartMask = MakeRowMask(0, Width - Size.X + 1);
+
+	for (int32 Y = 0; Y + Size.Y <= Rows.Num(); Y++)
+	{
+		uint64 Used = 0;
+		for (int32 Row = Y; Row < Y + Size.Y; Row++)
+		{
+			Used |= Rows[Row];
+		}
+
+		//Bit X stays set while X to X + Run - 1 are all free, doubling Run every step
+		uint64 Starts = ~Used;
+		for (int32 Run = 1; Run < Size.X && Starts; )
+		{
+			const int32 Shift = FMath::Min(Run, Size.X - Run);
+			Starts &= Starts >> Shift;
+			Run += Shift;
+		}
+
+		Starts &= StartMask;
+		if (Starts)
+		{
+			OutPosition = FIntPoint(static_cast<int32>(FMath::CountTrailingZeros64(Starts)), Y);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FRbsInventoryGrid::Fill(const FIntRect& Rect)
+{
+	if (!IsInside(Rect))
+		return;
+
+	const uint64 RectMask = MakeRowMask(Rect.Min.X, Rect.Width());
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+	{
+		Rows[Y] |= RectMask;
+	}
+}
+
+void FRbsInventoryGrid::Clear(const FIntRect& Rect)
+{
+	if (!IsInside(Rect))
+		return;
+
+	const uint64 RectMask = MakeRowMask(Rect.Min.X, Rect.Width());
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; Y++)
+	{
+		Rows[Y] &= ~RectMask;
+	}
+}
+
+bool FRbsInventoryGrid::IsInside(const FIntRect& Rect) const
+{
+	return Rect.Min.X >= 0 && Rect.Min.Y >= 0 && Rect.Max.X <= Width && Rect.Max.Y <= Rows.Num() && Rect.Width() > 0 && Rect.Height() > 0;
+}
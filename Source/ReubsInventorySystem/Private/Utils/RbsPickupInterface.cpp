@@ -3,5 +3,41 @@
 
 #include "Utils/RbsPickupInterface.h"
 
+#include "Components/PrimitiveComponent.h"
+#include "GameFramework/Actor.h"
 
 // Add default functionality here for any IRbsPickupInterface functions that are not pure virtual.
+
+int32 IRbsPickupInterface::GetPickupQuantity_Implementation() const
+{
+	return INDEX_NONE;
+}
+
+void IRbsPickupInterface::ResetPickup_Implementation()
+{
+	AActor* Pickup = Cast<AActor>(_getUObject());
+	if (!Pickup)
+		return;
+
+	Pickup->SetActorHiddenInGame(true);
+	Pickup->SetActorEnableCollision(false);
+	Pickup->SetActorTickEnabled(false);
+}
+
+void IRbsPickupInterface::ReactivatePickup_Implementation()
+{
+	AActor* Pickup = Cast<AActor>(_getUObject());
+	if (!Pickup)
+		return;
+
+	//Don't carry the velocity it had when it was pooled into the new drop
+	if (UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(Pickup->GetRootComponent()))
+	{
+		Root->SetPhysicsLinearVelocity(FVector::ZeroVector);
+		Root->SetPhysicsAngularVelocityInDegrees(FVector::ZeroVector);
+	}
+
+	Pickup->SetActorHiddenInGame(false);
+	Pickup->SetActorEnableCollision(true);
+	Pickup->SetActorTickEnabled(Pickup->PrimaryActorTick.bStartWithTickEnabled);
+}
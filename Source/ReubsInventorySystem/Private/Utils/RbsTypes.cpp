@@ -2,3 +2,85 @@
 
 #include "Utils/RbsTypes.h"
 
+bool FRbsItemHandle::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	//Shifted by one so the invalid handle is a single 0 byte
+	uint32 PackedIndex = static_cast<uint32>(Index + 1);
+	uint32 PackedGeneration = static_cast<uint32>(Generation);
+
+	Ar.SerializeIntPacked(PackedIndex);
+	if (PackedIndex != 0)
+	{
+		Ar.SerializeIntPacked(PackedGeneration);
+	}
+
+	if (Ar.IsLoading())
+	{
+		Index = static_cast<int32>(PackedIndex) - 1;
+		Generation = PackedIndex != 0 ? static_cast<int32>(PackedGeneration) : 0;
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+bool FRbsGridPlacement::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint8 bPlaced = IsValid() ? 1 : 0;
+	Ar.SerializeBits(&bPlaced, 1);
+
+	if (!bPlaced)
+	{
+		X = INDEX_NONE;
+		Y = INDEX_NONE;
+		bRotated = false;
+		bOutSuccess = true;
+		return true;
+	}
+
+	//Grids are at most 64 columns wide
+	uint32 PackedX = static_cast<uint32>(FMath::Clamp(X, 0, 63));
+	uint32 PackedY = static_cast<uint32>(FMath::Max(Y, 0));
+	uint8 bPackedRotated = bRotated ? 1 : 0;
+
+	Ar.SerializeInt(PackedX, 64);
+	Ar.SerializeIntPacked(PackedY);
+	Ar.SerializeBits(&bPackedRotated, 1);
+
+	if (Ar.IsLoading())
+	{
+		X = static_cast<int32>(PackedX);
+		Y = static_cast<int32>(PackedY);
+		bRotated = bPackedRotated != 0;
+	}
+
+	bOutSuccess = true;
+	return true;
+}
+
+bool FRbsInventoryCommand::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << Sequence;
+
+	uint8 TypeValue = static_cast<uint8>(Type);
+	Ar.SerializeBits(&TypeValue, 2);
+	Type = static_cast<ERbsInventoryCommandType>(TypeValue);
+
+	Handle.NetSerialize(Ar, Map, bOutSuccess);
+
+	if (Type == ERbsInventoryCommandType::Drop || Type == ERbsInventoryCommandType::Split)
+	{
+		uint32 PackedQuantity = static_cast<uint32>(FMath::Max(Quantity, 0));
+		Ar.SerializeIntPacked(PackedQuantity);
+		Quantity = static_cast<int32>(FMath::Min<uint32>(PackedQuantity, MAX_int32));
+	}
+	else if (Type == ERbsInventoryCommandType::Move)
+	{
+		uint32 PackedIndex = static_cast<uint32>(FMath::Max(TargetIndex, 0));
+		Ar.SerializeIntPacked(PackedIndex);
+		TargetIndex = static_cast<int32>(FMath::Min<uint32>(PackedIndex, MAX_int32));
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
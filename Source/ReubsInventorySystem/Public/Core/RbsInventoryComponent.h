@@ -5,10 +5,60 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "RbsInventoryItem.h"
+#include "RbsInventoryList.h"
+#include "Utils/RbsInventoryGrid.h"
 #include "Utils/RbsTypes.h"
 #include "RbsInventoryComponent.generated.h"
 
+//Recomputes the cached aggregates after every change and asserts they match the running totals
+#ifndef RBS_VERIFY_INVENTORY_AGGREGATES
+#define RBS_VERIFY_INVENTORY_AGGREGATES UE_BUILD_DEBUG
+#endif
+
+struct FStreamableHandle;
+class AController;
+class APawn;
+class APlayerController;
+class UNetConnection;
+class URbsInventoryConstraint;
+class URbsLootTable;
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnInventoryUpdated);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnInventoryItemChanged, URbsInventoryItem*, Item);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnContainerViewerChanged, APlayerController*, Viewer);
+
+/** Running totals and stacks of a single item class, Stacks is kept in the order of the item list on server and clients alike */
+struct FRbsItemClassBucket
+{
+	int32 Quantity = 0;
+	TArray<URbsInventoryItem*, TInlineAllocator<4>> Stacks;
+};
+
+/** What is left under WeightCapacity and each constraint, TryAddItems plans a batch against a copy so the live totals only change with the stacks */
+struct FRbsAddBudget
+{
+	double Weight = 0.0;
+	TArray<TArray<double>, TInlineAllocator<4>> ConstraintHeadroom;
+};
+
+/** A slot of the item handle table, Generation is bumped every time the slot is freed */
+struct FRbsItemHandleSlot
+{
+	URbsInventoryItem* Item = nullptr;
+	int32 Generation = 0;
+};
+
+/** A quantity change the owning client applied ahead of the server, keyed by the command that asked for it */
+struct FRbsQuantityPrediction
+{
+	uint16 Sequence = 0;
+	TWeakObjectPtr<URbsInventoryItem> Item;
+	int32 QuantityDelta = 0;
+	//Quantity shown once this prediction applied, the server quantity reaching it confirms the prediction without waiting for the ack
+	int32 TargetQuantity = 0;
+	bool bAcked = false;
+	double AckTime = 0.0;
+};
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class REUBSINVENTORYSYSTEM_API URbsInventoryComponent : public UActorComponent
@@ -19,6 +69,10 @@ public:
 	URbsInventoryComponent();
 
 	friend URbsInventoryItem;
+	friend FRbsInventoryEntry;
+	friend FRbsInventoryList;
+	friend FRbsItemInstance;
+	friend class FRbsInventoryUpdateScope;
 
 ////////////////////////////////////////////// Variables ///////////////////////////////////////////////////////////////
 	
@@ -28,7 +82,15 @@ public:
 
 protected:
 	UPROPERTY(ReplicatedUsing = OnReplicated_Items, VisibleAnywhere, Category = "Inventory")
-	TArray<TObjectPtr<URbsInventoryItem>> Items;
+	FRbsInventoryList Items;
+
+	/**Stacks of item definitions stored by value, they share Capacity and WeightCapacity with Items*/
+	UPROPERTY(ReplicatedUsing = OnReplicated_Items, VisibleAnywhere, Category = "Inventory")
+	FRbsItemInstanceList ItemInstances;
+
+	/**What the connections that can't see the stacks get instead, never sent to the owner*/
+	UPROPERTY(ReplicatedUsing = OnReplicated_Items, VisibleAnywhere, BlueprintReadOnly, Category = "Inventory")
+	FRbsInventorySummary Summary;
 
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory")
 	float WeightCapacity;
@@ -36,6 +98,58 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory", meta = (ClampMin=0, ClampMax=500))
 	int32 Capacity;
 
+	/**Extra limits on what the inventory holds, e.g. volume or at most 3 medkits. Item instances of definitions are only limited by Capacity and WeightCapacity*/
+	UPROPERTY(EditAnywhere, Instanced, BlueprintReadOnly, Category = "Inventory")
+	TArray<TObjectPtr<URbsInventoryConstraint>> Constraints;
+
+	/**Reuse consumed items through the world item pool instead of creating a new object for every stack*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory")
+	bool bUseItemPool = false;
+
+	/**Reuse dormant pickups from the world pickup pool when dropping items instead of spawning a new actor every time*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Drop")
+	bool bUsePickupPool = false;
+
+	/**Merge a drop into a pickup of the same class dropped within DropCoalesceRadius in the last DropCoalesceWindow seconds*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Drop")
+	bool bCoalesceDrops = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Drop", meta = (ClampMin = 0.0, EditCondition = bCoalesceDrops))
+	float DropCoalesceRadius = 100.f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Drop", meta = (ClampMin = 0.0, EditCondition = bCoalesceDrops))
+	float DropCoalesceWindow = 2.f;
+
+	/**Place every stack in a GridColumns x GridRows grid by the size of its item, on top of the Capacity stack limit*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Grid")
+	bool bUseGrid = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Grid", meta = (ClampMin = 1, ClampMax = 64, EditCondition = bUseGrid))
+	int32 GridColumns = 10;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Grid", meta = (ClampMin = 1, EditCondition = bUseGrid))
+	int32 GridRows = 10;
+
+	/**Seconds an acknowledged prediction waits for the server quantity before it is rolled back*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Prediction", meta = (ClampMin = 0.0))
+	float PredictionTimeout = 1.f;
+
+	/**For world containers: keep the owning actor net dormant while nobody has the container open*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Container")
+	bool bDormantWhenClosed = false;
+
+	/**For world containers: the items are rolled from this table the first time the inventory is opened, queried or changed on the server, not at level load*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Container")
+	TObjectPtr<URbsLootTable> LootTable;
+
+	/**Seed of the loot roll. 0 derives one from the owner's name, so every placed container rolls differently but the same on every run*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Container", meta = (EditCondition = "LootTable != nullptr"))
+	int32 LootSeed = 0;
+
+	/**Seconds between checks for viewers that left the game without closing the container*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Inventory|Container", meta = (ClampMin = 0.1))
+	float ViewerCheckInterval = 1.f;
+
 /*
  * Behaviour
  */
@@ -45,6 +159,26 @@ protected:
 	
 	UPROPERTY(BlueprintAssignable, Category = "Inventory")
 	FOnInventoryUpdated OnInventoryUpdated;
+
+	/**Called on server and clients whenever a single stack enters the inventory*/
+	UPROPERTY(BlueprintAssignable, Category = "Inventory")
+	FOnInventoryItemChanged OnItemAdded;
+
+	/**Called on server and clients whenever a single stack leaves the inventory*/
+	UPROPERTY(BlueprintAssignable, Category = "Inventory")
+	FOnInventoryItemChanged OnItemRemoved;
+
+	/**Called once the thumbnails requested by PrefetchThumbnails are loaded*/
+	UPROPERTY(BlueprintAssignable, Category = "Inventory")
+	FOnInventoryUpdated OnThumbnailsLoaded;
+
+	/**Called on the server when a player opens the container*/
+	UPROPERTY(BlueprintAssignable, Category = "Inventory|Container")
+	FOnContainerViewerChanged OnContainerOpened;
+
+	/**Called on the server when a player closes the container, or left while it was open*/
+	UPROPERTY(BlueprintAssignable, Category = "Inventory|Container")
+	FOnContainerViewerChanged OnContainerClosed;
 	
 
 /*
@@ -55,6 +189,79 @@ private:
 	UPROPERTY()
 	int32 ReplicatedItemsKey = 0;	
 
+	//Besides the owner, the only players that receive the stacks themselves
+	TArray<TWeakObjectPtr<APlayerController>> DetailViewers;
+
+	//The owning controller last put in the detail group, taken out again when someone else possesses the owner
+	TWeakObjectPtr<APlayerController> DetailOwner;
+
+	FTimerHandle ViewerCheckTimer;
+
+	bool bLootMaterialized = false;
+
+/*
+ * Aggregates
+ */
+
+	//Kept up to date on every add, remove and quantity change so queries never walk Items.
+	//Items keeps the stacks alive, the buckets only index them
+	double CachedWeight = 0.0;
+	int32 CachedStackCount = 0;
+	TMap<const UClass*, FRbsItemClassBucket> ClassBuckets;
+
+	//Clients append stacks to their bucket as they arrive, in any order, and sort the buckets once the update is in
+	bool bBucketsNeedSort = false;
+	TMap<const URbsItemDefinition*, int32> DefinitionQuantities;
+
+/*
+ * Grid
+ */
+
+	//Occupied cells, the server updates it as stacks come and go and clients rebuild it from the replicated placements
+	FRbsInventoryGrid Grid;
+
+/*
+ * Item handles
+ */
+
+	//Indexed by FRbsItemHandle::Index. Clients fill it from the replicated handles, only the server hands slots out
+	TArray<FRbsItemHandleSlot> HandleSlots;
+	TArray<int32> FreeHandleSlots;
+
+/*
+ * Update batching
+ */
+
+	//While above 0, OnInventoryUpdated, OnItemModified and the subobject key bump are held back until the batch ends
+	int32 UpdateBatchDepth = 0;
+	int32 BlueprintBatchDepth = 0;
+	bool bPendingInventoryUpdate = false;
+	bool bPendingSubobjectsDirty = false;
+	TArray<TWeakObjectPtr<URbsInventoryItem>> PendingModifiedItems;
+
+/*
+ * Streaming
+ */
+
+	//Keeps the prefetched thumbnails loaded until ReleaseThumbnails
+	TSharedPtr<FStreamableHandle> ThumbnailsHandle;
+
+/*
+ * Commands
+ */
+
+	//Gathered during the frame on the owning client, sent together by FlushInventoryCommands
+	TArray<FRbsInventoryCommand> PendingCommands;
+	uint16 NextCommandSequence = 1;
+	uint16 LastAckedCommandSequence = 0;
+	bool bCommandFlushScheduled = false;
+
+	TArray<FRbsQuantityPrediction> PendingPredictions;
+	FTimerHandle PredictionTimeoutTimer;
+
+	//Larger frames are split over a few RPCs so a single one never gets close to the reliable bunch limit
+	static constexpr int32 MaxCommandsPerBatch = 64;
+
 ////////////////////////////////////////////// Functions ///////////////////////////////////////////////////////////////	
 
 /*
@@ -63,11 +270,127 @@ private:
 
 public:
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void OnRegister() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void ReadyForReplication() override;
+
+	/**
+	 * Legacy path, only used when "Replicate Using Registered SubObject List" is off.
+	 * Turn that flag on to let the engine replicate each item on its own instead of re-checking every item whenever one changes.
+	 */
 	virtual bool ReplicateSubobjects(UActorChannel* Channel, FOutBunch* Bunch, FReplicationFlags* RepFlags) override;
 
+	/**Return true if Connection gets every stack of the inventory, and not just Summary. Only the owner and the detail viewers do*/
+	bool CanReceiveDetail(const UNetConnection* Connection) const;
+
+	/**Let Viewer receive every stack of the inventory, e.g. while it has the container open*/
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Inventory")
+	void AddDetailViewer(APlayerController* Viewer);
+
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Inventory")
+	void RemoveDetailViewer(APlayerController* Viewer);
+
+	/**
+	 * Start a viewing session: Viewer receives every stack until CloseContainer, and the owning actor wakes up if it was dormant.
+	 * Call it on the server, e.g. from the interaction RPC of the player.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Inventory|Container")
+	bool OpenContainer(APlayerController* Viewer);
+
+	/**End the viewing session of Viewer, the owning actor goes dormant again once the last viewer is gone*/
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Inventory|Container")
+	void CloseContainer(APlayerController* Viewer);
+
+	UFUNCTION(BlueprintPure, Category = "Inventory|Container")
+	bool IsContainerOpenBy(const APlayerController* Viewer) const;
+
+	UFUNCTION(BlueprintPure, Category = "Inventory|Container")
+	FORCEINLINE int32 GetContainerViewerCount() const { return DetailViewers.Num(); }
+
+	/**Create the items of LootTable, done on its own the first time the container is opened, queried or changed on the server*/
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Inventory|Container")
+	void MaterializeLoot();
+
+	UFUNCTION(BlueprintPure, Category = "Inventory|Container")
+	FORCEINLINE bool HasPendingLoot() const { return LootTable && !bLootMaterialized; }
+
+	/**Return the summary other players see, on the server and the clients that aren't the owner*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FORCEINLINE FRbsInventorySummary GetSummary() const { return Summary; }
+
 private:
 	UFUNCTION()
 	void OnReplicated_Items();
+
+	void HandleEntryAdded(URbsInventoryItem* Item, const FRbsItemHandle& Handle);
+	void HandleEntryRemoved(URbsInventoryItem* Item);
+
+	/**Entry orders changed, sort the class buckets to match*/
+	void HandleEntriesReordered();
+
+	void HandleInstanceAdded(FRbsItemInstance& Instance);
+	void HandleInstanceRemoved(FRbsItemInstance& Instance);
+	void HandleInstanceChanged(FRbsItemInstance& Instance);
+
+	/**Items and ItemInstances are push based, call these after every change to the lists*/
+	void MarkItemsDirty();
+	void MarkItemInstancesDirty();
+
+	/**Let the legacy ReplicateSubobjects path know an item needs to be checked again*/
+	void MarkSubobjectsDirty();
+
+	/**Refill Grid from the placements of the entries*/
+	void RebuildGrid();
+
+	/**Find a free placement for Item in InGrid, trying it sideways when it doesn't fit upright*/
+	static bool FindGridSpace(const URbsInventoryItem* Item, const FRbsInventoryGrid& InGrid, FRbsGridPlacement& OutPlacement);
+
+	/**Whether one more stack of Item's class fits, by Capacity and by the grid*/
+	bool CanAddStack(const URbsInventoryItem* Item) const;
+
+	/**Rebuild Summary from the aggregates, it is only marked dirty when something in it changed*/
+	void RefreshSummary();
+
+	/**Net condition group the items are registered in with the registered subobject list, its members are the owner and the detail viewers*/
+	FName GetDetailNetGroup() const;
+	APlayerController* GetOwningController() const;
+	/**
+	 * Roll the loot before a query answers, so it never reports an unvisited container as empty.
+	 * Rolling is the only change a query may make, and only the server does it. The inventory's own bookkeeping reads the aggregates directly and never gets here.
+	 */
+	FORCEINLINE void MaterializeLootForQuery() const
+	{
+		if (HasPendingLoot() && GetOwnerRole() == ROLE_Authority)
+		{
+			const_cast<URbsInventoryComponent*>(this)->MaterializeLoot();
+		}
+	}
+
+	/**Swap the previous owning controller in the detail group for the current one*/
+	void IncludeOwnerInDetailGroup();
+
+	UFUNCTION()
+	void OnOwnerControllerChanged(APawn* Pawn, AController* OldController, AController* NewController);
+
+	/**Close the container for viewers that are gone, then sleep again if nobody is left*/
+	void CheckContainerViewers();
+	void UpdateContainerDormancy();
+
+/*
+ * Aggregates
+ */
+
+	void HandleItemQuantityChanged(URbsInventoryItem* Item);
+
+	/**Swap what Instance counts in the aggregates for Definition and Quantity*/
+	void AccountInstance(FRbsItemInstance& Instance, const URbsItemDefinition* Definition, const int32 Quantity);
+
+#if RBS_VERIFY_INVENTORY_AGGREGATES
+	void VerifyAggregates() const;
+#else
+	FORCEINLINE void VerifyAggregates() const {}
+#endif
 	
 /*
  * Behaviour
@@ -76,35 +399,233 @@ private:
 private:
 	
 	URbsInventoryItem* AddItem(URbsInventoryItem* Item);
+	URbsInventoryItem* AddItemStack(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity);
+
+	/**Start tracking an item object that isn't in any inventory yet*/
+	void AdoptItem(URbsInventoryItem* Item);
+
+	/**Reserve a free slot of the handle table, it is filled when the entry is added*/
+	FRbsItemHandle AllocateItemHandle();
+
+	/**Hand a removed item back to the item pool, when enabled*/
+	void RecycleItem(URbsInventoryItem* Item);
+
+	/**Move up to Quantity into the existing stacks of ItemClass, return how much went in*/
+	int32 TopUpStacks(const UClass* ItemClass, const int32 Quantity, URbsInventoryItem*& OutLastStack);
+
+	int32 GetMaxAddableByWeight(const float ItemWeight) const;
+
+	/**How many of Item still fit by WeightCapacity and every constraint, OutFailureText is set to the reason when none does*/
+	int32 GetMaxAddable(const URbsInventoryItem* Item, FText* OutFailureText = nullptr) const;
+
+	FRbsAddBudget MakeAddBudget() const;
+
+	/**How many of Item fit in Budget, as GetMaxAddable but against a budget instead of the live totals*/
+	int32 GetMaxAddable(const URbsInventoryItem* Item, const FRbsAddBudget& Budget, FText* OutFailureText = nullptr) const;
+
+	void SpendAddBudget(const URbsInventoryItem* Item, const int32 Quantity, FRbsAddBudget& Budget) const;
+
+	/**Tell the constraints the quantity of Item in the inventory changed by Delta*/
+	void UpdateConstraints(const URbsInventoryItem* Item, const int32 Delta);
+
+	/**How many of Item's class still fit in the free room of our stacks and the stacks we can still create*/
+	int32 GetMaxAddableByStacks(const URbsInventoryItem* Item) const;
+	static FItemAddResult MakeAddResult(URbsInventoryItem* LastStack, const int32 AmountToGive, const int32 AmountGiven);
+
+	void BeginUpdateBatch();
+	void EndUpdateBatch();
+
+	/**Broadcast OnInventoryUpdated, or defer it to the end of the current batch*/
+	void BroadcastInventoryUpdated();
+
+	/**Return true if Item's OnItemModified was deferred to the end of the current batch*/
+	bool DeferItemModified(URbsInventoryItem* Item);
+
+	void FlushBlueprintUpdateBatches();
+
+	void HandleThumbnailsLoaded();
+
+	/**Queue a command for the server and return its sequence, or 0 when Item has no handle yet*/
+	uint16 QueueInventoryCommand(const ERbsInventoryCommandType Type, const URbsInventoryItem* Item, const int32 Quantity = 0, const int32 TargetIndex = INDEX_NONE);
+	void FlushInventoryCommands();
+
+	/**Show QuantityDelta on Item right away, until the server answers command Sequence*/
+	void PredictQuantityChange(URbsInventoryItem* Item, const int32 QuantityDelta, const uint16 Sequence);
+
+	/**Take the prediction at Index back off its item, the item isn't notified*/
+	void RemovePrediction(const int32 Index);
+
+	/**
+	 * The server quantity of Item arrived. It holds every acknowledged prediction, and the ones it already moved past,
+	 * since the quantity may replicate before the ack does.
+	 */
+	void RetireConfirmedPredictions(const URbsInventoryItem* Item);
+	void DiscardPredictions(const URbsInventoryItem* Item);
+	void ExpirePredictions();
+
+	/**Run a command sent by the owning client, return false when it had to be rejected*/
+	bool ExecuteInventoryCommand(const FRbsInventoryCommand& Command);
+
+	UFUNCTION(Server, Reliable)
+	void ServerExecuteInventoryCommands(const TArray<FRbsInventoryCommand>& Commands);
+
+	/**Every command up to LastSequence was handled, the ones in RejectedSequences did nothing*/
+	UFUNCTION(Client, Reliable)
+	void ClientAckInventoryCommands(uint16 LastSequence, const TArray<uint16>& RejectedSequences);
+
+	void OnPickupClassLoaded(TSoftClassPtr<AActor> SoftPickupClass, FTransform SpawnTransform, int32 Quantity);
+	void SpawnPickup(UClass* PickupClass, const FTransform& SpawnTransform, const int32 Quantity);
+	FTransform GetDropTransform() const;
+
+public:
+
+	/**
+	 * Hold back OnInventoryUpdated and OnItemModified until the matching EndInventoryUpdateBatch, then fire each of them once.
+	 * A batch left open is closed at the start of the next frame.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void BeginInventoryUpdateBatch();
+
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void EndInventoryUpdateBatch();
+
+	FORCEINLINE bool IsUpdateBatchOpen() const { return UpdateBatchDepth > 0; }
+
+	/**
+	 * Start streaming the soft thumbnails of everything in the inventory, e.g. when the inventory UI opens.
+	 * OnThumbnailsLoaded fires once they are in, they stay loaded until ReleaseThumbnails. Does nothing on dedicated servers.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void PrefetchThumbnails();
+
+	/**Let the thumbnails loaded by PrefetchThumbnails unload, e.g. when the inventory UI closes*/
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void ReleaseThumbnails();
 
 public:	
 	
+	/**Add copies of Item, Item itself is left untouched. Use TryMoveItemIn to move it in instead*/
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	FItemAddResult TryAddItem(class URbsInventoryItem* Item);
 	
+	/**Add Quantity of ItemClass, only the stacks that end up in the inventory are created*/
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	FItemAddResult TryAddItemFromClass(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity = 1);
 
+	/**
+	 * Move Item itself into the inventory instead of cloning it. Existing stacks are topped up first, the rest moves in as Item when it fits.
+	 * Whatever couldn't be added is left on Item. Item must not belong to another inventory.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	FItemAddResult TryMoveItemIn(URbsInventoryItem* Item);
+
 	FItemAddResult TryAddItem_Internal(URbsInventoryItem* Item);
+	FItemAddResult TryAddItem_Internal(TSubclassOf<URbsInventoryItem> ItemClass, const int32 Quantity);
+
+	/**
+	 * Add many items at once, e.g. when looting a container. Stacking is planned for the whole batch up front,
+	 * then applied with a single OnInventoryUpdated and a single replication update.
+	 * Returns one result per spec, in the same order.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	TArray<FItemAddResult> TryAddItems(const TArray<FItemSpec>& ItemSpecs);
+
+	/**Roll Table with Seed and add everything it drops in one batch, see TryAddItems*/
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	TArray<FItemAddResult> TryAddLoot(const URbsLootTable* Table, const int32 Seed);
+
+	/**
+	 * Move up to Quantity of Item from From into To, topping up the stacks of its class in To first. Returns how much was moved.
+	 * How much To can take is checked before anything changes, so nothing is lost or duplicated on the way.
+	 * When the rest of the stack moves and both inventories belong to the same actor the object itself changes inventory,
+	 * otherwise To gets pooled stacks and an emptied Item is recycled. Each side broadcasts a single update.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Inventory")
+	static int32 TransferItem(URbsInventoryComponent* From, URbsInventoryComponent* To, URbsInventoryItem* Item, const int32 Quantity);
+
+	/**
+	 * Add Quantity of Definition as item instances, topping up the instances of it we already have first.
+	 * AddedItem is always null in the result, the stacks aren't objects.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	FItemAddResult TryAddDefinition(const URbsItemDefinition* Definition, const int32 Quantity = 1);
+
+	/**Remove up to Quantity of Definition, emptying the newest instances first. Returns how much was removed*/
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	int32 ConsumeDefinition(const URbsItemDefinition* Definition, const int32 Quantity = 1);
+
+	/**Remove up to Quantity from the instance at InstanceIndex, an instance consumed to 0 is removed*/
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	int32 ConsumeItemInstance(const int32 InstanceIndex, const int32 Quantity = 1);
+
+	/**Set a payload value on the instance at InstanceIndex*/
+	UFUNCTION(BlueprintCallable, Category = "Inventory")
+	void SetItemInstanceValue(const int32 InstanceIndex, const FName Name, const float Value);
 
+	/**Remove Item from the inventory. The caller keeps the item, it is never recycled by the item pool*/
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	bool RemoveItem(URbsInventoryItem* Item);
 	
+	/**Remove Quantity from Item, a stack consumed to 0 is removed and goes back to the item pool when enabled*/
 	int32 ConsumeItem(URbsInventoryItem* Item);
 	int32 ConsumeItem(URbsInventoryItem* Item, const int32 Quantity);
 
 	UFUNCTION(BlueprintCallable, Category = "Items")
 	void UseItem(URbsInventoryItem* Item);
 
+	/**Only for stacks that don't have a handle yet, everything else goes through the command batch*/
 	UFUNCTION(Server, Reliable)
 	void ServerUseItem(URbsInventoryItem* Item);
 
+	/**Spawn a pickup of Item holding Quantity. A soft pickup class is loaded asynchronously first, so the pickup may show up a few frames later*/
 	UFUNCTION(BlueprintCallable, Category = "Items")
 	void DropItem(URbsInventoryItem* Item, const int32 Quantity);
 
+	/**Only for stacks that don't have a handle yet, everything else goes through the command batch*/
 	UFUNCTION(Server, Reliable)
 	void ServerDropItem(URbsInventoryItem* Item, const int32 Quantity);
 
+	/**
+	 * Move Quantity off Item into a new stack and return it. Needs a free slot and must leave at least 1 on Item.
+	 * Clients queue the request for the server and get null back, the new stack shows up once it replicates.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	URbsInventoryItem* SplitStack(URbsInventoryItem* Item, const int32 Quantity);
+
+	/**
+	 * Move Item to NewIndex in the item order, the items in between shift by one. Clients queue the request for the server.
+	 * Only the moved entry is sent again in most cases, clients just see the new order and no item leaves or enters the inventory.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Items")
+	bool MoveItem(URbsInventoryItem* Item, const int32 NewIndex);
+
+	/**Merge the partial stacks of each class into as few stacks as possible on the server. Returns how many stacks were freed*/
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Items")
+	int32 ConsolidateStacks();
+
+	/**Move Item to the cell X, Y of the grid on the server, turned sideways when bRotated. Fails when the cells are taken by other stacks*/
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Items|Grid")
+	bool PlaceItemInGrid(URbsInventoryItem* Item, const int32 X, const int32 Y, const bool bRotated);
+
+	/**Turn Item sideways in place on the server*/
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Items|Grid")
+	bool RotateItemInGrid(URbsInventoryItem* Item);
+
+	/**Whether Item could go to X, Y, on the server and clients alike, e.g. to preview a drag*/
+	UFUNCTION(BlueprintPure, Category = "Items|Grid")
+	bool CanPlaceItemInGrid(const URbsInventoryItem* Item, const int32 X, const int32 Y, const bool bRotated) const;
+
+	/**Where Item sits in the grid, invalid when the inventory has no grid*/
+	UFUNCTION(BlueprintPure, Category = "Items|Grid")
+	FRbsGridPlacement GetItemGridPlacement(const URbsInventoryItem* Item) const;
+
+	/**Reorder the items by Key on the server, items that tie keep their current order*/
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Items")
+	void SortItems(const ERbsItemSortKey Key);
+
+	/**Last command sequence the server acknowledged on this owning client*/
+	FORCEINLINE uint16 GetLastAckedCommandSequence() const { return LastAckedCommandSequence; }
+
 protected:
 
 	UFUNCTION()
@@ -121,11 +642,80 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Inventory")
 	FORCEINLINE int32 GetCapacity() const { return Capacity; }
 
+	/**Copies every item, prefer GetItemCount/GetItemAt in Blueprint and ViewItems in C++*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	TArray<URbsInventoryItem*> GetItems() const;
+
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FORCEINLINE int32 GetItemCount() const { MaterializeLootForQuery(); return Items.Num(); }
+
+	/**Return the item at Index, in the same order as GetItems. May be null on clients while the item is still replicating*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	URbsInventoryItem* GetItemAt(const int32 Index) const;
+
+	/**Iterate every item without copying, for (URbsInventoryItem* Item : Inventory->ViewItems())*/
+	FORCEINLINE TRbsInventoryItemRange<> ViewItems() const { MaterializeLootForQuery(); return TRbsInventoryItemRange<>(Items.Entries); }
+
+	/**Iterate the items that pass Predicate(const URbsInventoryItem*) without copying*/
+	template<typename PredicateType>
+	FORCEINLINE TRbsInventoryItemRange<PredicateType> ViewItemsWhere(PredicateType Predicate) const
+	{
+		MaterializeLootForQuery();
+		return TRbsInventoryItemRange<PredicateType>(Items.Entries, MoveTemp(Predicate));
+	}
+
+	FORCEINLINE auto ViewItemsOfClass(const UClass* ItemClass, const bool bIncludeChildClasses = false) const
+	{
+		return ViewItemsWhere([ItemClass, bIncludeChildClasses](const URbsInventoryItem* Item)
+		{
+			return bIncludeChildClasses ? Item->IsA(ItemClass) : Item->GetClass() == ItemClass;
+		});
+	}
+
+	FORCEINLINE auto ViewItemsOfCategory(const FText& Category) const
+	{
+		return ViewItemsWhere([Category](const URbsInventoryItem* Item) { return Item->Category.EqualTo(Category); });
+	}
+
+	FORCEINLINE auto ViewStackableItems(const bool bStackable = true) const
+	{
+		return ViewItemsWhere([bStackable](const URbsInventoryItem* Item) { return Item->bStackable == bStackable; });
+	}
+
+	/**How many of ItemClass could still be added by weight and constraints, before Capacity and the grid*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetMaxAddableQuantity(TSubclassOf<URbsInventoryItem> ItemClass) const;
+
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FORCEINLINE float GetCurrentWeight() const { MaterializeLootForQuery(); return static_cast<float>(CachedWeight); }
+
+	/**Return the amount of stacks in the inventory, items and item instances alike*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FORCEINLINE int32 GetStackCount() const { MaterializeLootForQuery(); return CachedStackCount; }
+
+	/**Return the total quantity of ItemClass across all of its stacks*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 GetTotalQuantity(TSubclassOf<URbsInventoryItem> ItemClass, const bool bIncludeChildClasses = false) const;
+
+	/**Every stack of exactly ItemClass, in the order they were added. Doesn't allocate, don't hold on to it across inventory changes*/
+	TConstArrayView<URbsInventoryItem*> GetStacksOfClass(const UClass* ItemClass) const;
+
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FORCEINLINE int32 GetItemInstanceCount() const { MaterializeLootForQuery(); return ItemInstances.Num(); }
+
+	/**Return a copy of the instance at Index, in C++ prefer ViewItemInstances*/
 	UFUNCTION(BlueprintPure, Category = "Inventory")
-	FORCEINLINE TArray<URbsInventoryItem*> GetItems() const { return Items; }
+	FRbsItemInstance GetItemInstanceAt(const int32 Index) const;
+
+	/**Every item instance in the inventory. Doesn't allocate, don't hold on to it across inventory changes*/
+	FORCEINLINE TConstArrayView<FRbsItemInstance> ViewItemInstances() const { MaterializeLootForQuery(); return ItemInstances.Entries; }
 
+	/**Return the total quantity of Definition across all of its instances*/
 	UFUNCTION(BlueprintPure, Category = "Inventory")
-	float GetCurrentWeight() const;
+	int32 GetDefinitionQuantity(const URbsItemDefinition* Definition) const;
+
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FORCEINLINE bool HasDefinition(const URbsItemDefinition* Definition, const int32 Quantity = 1) const { return GetDefinitionQuantity(Definition) >= Quantity; }
 
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	void SetWeightCapacity(const float NewWeightCapacity);
@@ -133,9 +723,39 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Inventory")
 	void SetCapacity(const int32 NewCapacity);
 
-	/**Return true if we have a given amount of an item*/
+	/**Return true if we have a given amount of an item, counting every stack of it*/
 	UFUNCTION(BlueprintPure, Category = "Inventory")
-	bool HasItem(TSubclassOf <URbsInventoryItem> ItemClass, const int32 Quantity = 1) const;
+	bool HasItem(TSubclassOf <URbsInventoryItem> ItemClass, const int32 Quantity = 1, const bool bIncludeChildClasses = false) const;
+
+	/**Return true if we have every quantity of Requirements at once, by exact class*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	bool HasItems(const FRbsItemRequirements& Requirements) const;
+
+	/**Return how many times we could take every quantity of Requirements, e.g. how many times a recipe can be crafted*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	int32 CountItems(const FRbsItemRequirements& Requirements) const;
+
+	/**
+	 * CountItems for many requirement sets at once, e.g. every recipe of a crafting menu.
+	 * Every ingredient is a single lookup in the per-class totals the inventory keeps, the stacks are never walked.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	TArray<int32> CountItemsBulk(const TArray<FRbsItemRequirements>& RequirementSets) const;
+
+	/**
+	 * Remove every quantity of Requirements on the server, taking from the last stacks of each class first.
+	 * Nothing is removed unless everything is there, and the whole removal goes out as a single update.
+	 */
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "Inventory")
+	bool ConsumeItems(const FRbsItemRequirements& Requirements);
+
+	/**Return the exact stack Handle points to, or null once that stack left the inventory*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	URbsInventoryItem* ResolveItemHandle(const FRbsItemHandle& Handle) const;
+
+	/**Return true if Item itself is one of our stacks*/
+	UFUNCTION(BlueprintPure, Category = "Inventory")
+	FORCEINLINE bool ContainsItem(const URbsInventoryItem* Item) const { return IsValid(Item) && Item->OwningInventory == this; }
 
 	/**Return the first item with the same class as a given Item*/
 	UFUNCTION(BlueprintPure, Category = "Inventory")
@@ -149,8 +769,29 @@ public:
 	UFUNCTION(BlueprintPure, Category = "Inventory")
 	URbsInventoryItem* FindItemByClass(TSubclassOf<URbsInventoryItem> ItemClass) const;
 
-	/**Get all inventory items that are a child of ItemClass. Useful for grabbing all weapons, all food, etc*/
+	/**Get all inventory items of ItemClass. With bIncludeChildClasses also grabs its children, useful for grabbing all weapons, all food, etc*/
 	UFUNCTION(BlueprintPure, Category = "Inventory")
-	TArray<URbsInventoryItem*> FindItemsByClass(TSubclassOf<URbsInventoryItem> ItemClass) const;
+	TArray<URbsInventoryItem*> FindItemsByClass(TSubclassOf<URbsInventoryItem> ItemClass, const bool bIncludeChildClasses = false) const;
 	
 };
+
+/**
+ * Holds back the notifications of an inventory while in scope, so many changes only rebuild the UI once.
+ *
+ *	{
+ *		FRbsInventoryUpdateScope UpdateScope(Inventory);
+ *		Inventory->ConsumeItem(Wood, 4);
+ *		Inventory->TryAddItemFromClass(PlankClass, 2);
+ *	}
+ */
+class REUBSINVENTORYSYSTEM_API FRbsInventoryUpdateScope
+{
+public:
+	explicit FRbsInventoryUpdateScope(URbsInventoryComponent* InInventory);
+	~FRbsInventoryUpdateScope();
+
+	UE_NONCOPYABLE(FRbsInventoryUpdateScope);
+
+private:
+	TWeakObjectPtr<URbsInventoryComponent> Inventory;
+};
@@ -0,0 +1,177 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "RbsInventoryConstraint.generated.h"
+
+class URbsInventoryItem;
+
+/**
+ * A limit on what an inventory may hold, added to URbsInventoryComponent::Constraints on top of Capacity and WeightCapacity.
+ * Each constraint keeps its own running totals, updated by the inventory whenever a stack quantity changes,
+ * so asking how much of an item still fits never walks the items.
+ * Batches are planned against a copy of the headroom left under each limit, so the running totals only change with the stacks.
+ */
+UCLASS(Abstract, BlueprintType, EditInlineNew, DefaultToInstanced, CollapseCategories)
+class REUBSINVENTORYSYSTEM_API URbsInventoryConstraint : public UObject
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsInventoryConstraint();
+
+	/**Shown in the add result when this constraint stops an item from being added at all*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint")
+	FText FailureText;
+
+	/**How many of Item still fit, MAX_int32 when this constraint doesn't limit it*/
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item) const { return MAX_int32; }
+
+	/**The quantity of Item in the inventory changed by Delta*/
+	virtual void AddQuantity(const URbsInventoryItem* Item, const int32 Delta) {}
+
+	/**Forget the running totals, the inventory adds its stacks again right after*/
+	virtual void ResetAggregates() {}
+
+	/**What is left under each limit of this constraint, one value per limit*/
+	virtual void GetHeadroom(TArray<double>& OutHeadroom) const {}
+
+	/**How many of Item fit in Headroom, as filled by GetHeadroom*/
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const { return MAX_int32; }
+
+	/**Take Quantity of Item out of Headroom*/
+	virtual void SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const {}
+};
+
+/** Caps the total weight, e.g. for a pouch that holds less than the bag it's in */
+UCLASS(meta = (DisplayName = "Weight Limit"))
+class REUBSINVENTORYSYSTEM_API URbsWeightConstraint : public URbsInventoryConstraint
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsWeightConstraint();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint", meta = (ClampMin = 0.0))
+	float MaxWeight = 50.f;
+
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item) const override;
+	virtual void AddQuantity(const URbsInventoryItem* Item, const int32 Delta) override;
+	virtual void ResetAggregates() override { CurrentWeight = 0.0; }
+	virtual void GetHeadroom(TArray<double>& OutHeadroom) const override;
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const override;
+	virtual void SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const override;
+
+private:
+	double CurrentWeight = 0.0;
+};
+
+/** Caps the total volume of the items, see URbsInventoryItem::Volume */
+UCLASS(meta = (DisplayName = "Volume Limit"))
+class REUBSINVENTORYSYSTEM_API URbsVolumeConstraint : public URbsInventoryConstraint
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsVolumeConstraint();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint", meta = (ClampMin = 0.0))
+	float MaxVolume = 100.f;
+
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item) const override;
+	virtual void AddQuantity(const URbsInventoryItem* Item, const int32 Delta) override;
+	virtual void ResetAggregates() override { CurrentVolume = 0.0; }
+	virtual void GetHeadroom(TArray<double>& OutHeadroom) const override;
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const override;
+	virtual void SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const override;
+
+private:
+	double CurrentVolume = 0.0;
+};
+
+USTRUCT(BlueprintType)
+struct FRbsCategoryLimit
+{
+	GENERATED_BODY()
+
+	/**Matched against URbsInventoryItem::Category by its source string, so it holds in every language*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint")
+	FText Category;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint", meta = (ClampMin = 0))
+	int32 MaxQuantity = 1;
+};
+
+/** Caps the quantity of the items of some categories, e.g. at most 3 medkits */
+UCLASS(meta = (DisplayName = "Category Limits"))
+class REUBSINVENTORYSYSTEM_API URbsCategoryConstraint : public URbsInventoryConstraint
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsCategoryConstraint();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint")
+	TArray<FRbsCategoryLimit> Limits;
+
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item) const override;
+	virtual void AddQuantity(const URbsInventoryItem* Item, const int32 Delta) override;
+	virtual void ResetAggregates() override;
+	virtual void GetHeadroom(TArray<double>& OutHeadroom) const override;
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const override;
+	virtual void SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const override;
+
+private:
+	/**Index in Limits of the category of ItemClass, the text is only compared the first time a class shows up*/
+	int32 FindLimit(const UClass* ItemClass) const;
+
+	mutable TMap<const UClass*, int32> ClassLimits;
+	TArray<int32> Quantities;
+};
+
+USTRUCT(BlueprintType)
+struct FRbsClassLimit
+{
+	GENERATED_BODY()
+
+	/**Counts ItemClass and its child classes*/
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint")
+	TSubclassOf<URbsInventoryItem> ItemClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint", meta = (ClampMin = 0))
+	int32 MaxQuantity = 1;
+};
+
+/** Caps the quantity of some item classes */
+UCLASS(meta = (DisplayName = "Class Limits"))
+class REUBSINVENTORYSYSTEM_API URbsClassConstraint : public URbsInventoryConstraint
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsClassConstraint();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Constraint")
+	TArray<FRbsClassLimit> Limits;
+
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item) const override;
+	virtual void AddQuantity(const URbsInventoryItem* Item, const int32 Delta) override;
+	virtual void ResetAggregates() override;
+	virtual void GetHeadroom(TArray<double>& OutHeadroom) const override;
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const override;
+	virtual void SpendHeadroom(const URbsInventoryItem* Item, const int32 Quantity, TArrayView<double> Headroom) const override;
+
+private:
+	/**Indices in Limits that count ItemClass, the class hierarchy is only checked the first time a class shows up. A copy, adding a class to the cache moves the others*/
+	TArray<int32, TInlineAllocator<2>> FindLimits(const UClass* ItemClass) const;
+
+	mutable TMap<const UClass*, TArray<int32, TInlineAllocator<2>>> ClassLimits;
+	TArray<int32> Quantities;
+};
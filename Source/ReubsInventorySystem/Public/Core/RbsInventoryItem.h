@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "Utils/RbsTypes.h"
 #include "RbsInventoryItem.generated.h"
 
 class URbsItemTooltip;
@@ -39,6 +40,14 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
 	UTexture2D* Thumbnail{};
 
+	/**Used when PickupClass is empty. Only loaded when the item is dropped, so the pickup blueprint doesn't load with the item*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	TSoftClassPtr<AActor> SoftPickupClass;
+
+	/**Used when Thumbnail is empty. Streamed in by URbsInventoryComponent::PrefetchThumbnails, never loaded on dedicated servers*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	TSoftObjectPtr<UTexture2D> SoftThumbnail;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item")
 	FText DisplayName;
 
@@ -57,6 +66,10 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item", meta = (ClampMin = 0.0))
 	float Weight = 1.f;
 
+	/**Room a single item takes in inventories with a URbsVolumeConstraint*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item", meta = (ClampMin = 0.0))
+	float Volume = 0.f;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item")
 	bool bStackable = true;
 
@@ -66,12 +79,47 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadWrite, Category = "Item")
 	TSubclassOf<URbsItemTooltip> ItemTooltip;
 
+	/**Tell players that can't look into the inventory the owner holds this item, through the inventory summary*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	bool bVisibleInSummary = false;
+
+	/**Cells the item takes in grid inventories*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item|Grid", meta = (ClampMin = 1, ClampMax = 64))
+	int32 GridWidth = 1;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item|Grid", meta = (ClampMin = 1, ClampMax = 64))
+	int32 GridHeight = 1;
+
+	/**How much a single Use consumes, owning clients show it right away instead of waiting for the server*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item", meta = (ClampMin = 0))
+	int32 PredictedUseConsumption = 0;
+
 	UPROPERTY(ReplicatedUsing = OnRep_Quantity, EditAnywhere, Category = "Item", meta = (UIMin = 1, EditCondition = bStackable))
 	int32 Quantity = 1;
 	
 	UPROPERTY()
 	TObjectPtr<URbsInventoryComponent> OwningInventory;
 
+private:
+	friend URbsInventoryComponent;
+
+	//The quantity currently counted in the OwningInventory aggregates
+	int32 AccountedQuantity = 0;
+
+	//OnItemModified is waiting for the OwningInventory update batch to end
+	bool bPendingModifiedBroadcast = false;
+
+	//Where the item is in the slot table of OwningInventory
+	FRbsItemHandle Handle;
+
+	//FRbsInventoryEntry::Order of the item's entry, the class buckets of OwningInventory are sorted by it
+	int32 EntryOrder = 0;
+
+	//Sum of the changes the owning client predicted and the server hasn't confirmed yet, always 0 on the server
+	int32 PredictedQuantityDelta = 0;
+
+public:
+
 ///////////////////////////////////////////////////// Functions ////////////////////////////////////////////////////////
 
 
@@ -102,6 +150,7 @@ public:
 
 public:
 	
+	/**Cleared when the stack is recycled. Clients clear it as soon as the stack leaves its inventory, they can't tell a recycled stack from a moved one*/
 	UPROPERTY(BlueprintAssignable)
 	FOnItemModified OnItemModified;
 
@@ -110,6 +159,13 @@ public:
 	UFUNCTION(BlueprintNativeEvent)
 	void AddedToInventory(URbsInventoryComponent* Inventory);
 
+	/**Called when the item goes back to the item pool, reset any state added by child classes here*/
+	UFUNCTION(BlueprintNativeEvent)
+	void OnRecycled();
+
+	/**Bring the item back to its class defaults so the item pool can hand it out as a brand new stack*/
+	void ResetForReuse();
+
 	UFUNCTION(BlueprintCallable, Category = "Item")
 	void SetQuantity(const int32 NewQuantity);
 	
@@ -117,18 +173,36 @@ public:
  * Helpers
  */
 	
+	/**False once the owning client predicted the whole stack away*/
 	UFUNCTION(BlueprintPure, Category = "Item")
-	FORCEINLINE bool ShouldShowInInventory() const { return true; } 
+	FORCEINLINE bool ShouldShowInInventory() const { return GetQuantity() > 0; } 
+
+	/**Return Thumbnail, or SoftThumbnail when it is already loaded. Never loads anything*/
+	UFUNCTION(BlueprintPure, Category = "Item")
+	UTexture2D* GetThumbnail() const;
+
+	/**Return PickupClass, or SoftPickupClass when it is already loaded. Never loads anything*/
+	UFUNCTION(BlueprintPure, Category = "Item")
+	TSubclassOf<AActor> GetPickupClass() const;
 
 	UFUNCTION(BlueprintCallable, Category = "Item")
-	FORCEINLINE float GetStackWeight() const { return Quantity * Weight; }
+	FORCEINLINE float GetStackWeight() const { return GetQuantity() * Weight; }
 
+	/**Return the quantity including the changes predicted on the owning client*/
 	UFUNCTION(BlueprintCallable, Category = "Item")
-	FORCEINLINE int GetQuantity() const { return Quantity; }
+	FORCEINLINE int GetQuantity() const { return Quantity + PredictedQuantityDelta; }
+
+	/**Return the last quantity the server sent, without predictions*/
+	UFUNCTION(BlueprintPure, Category = "Item")
+	FORCEINLINE int32 GetAuthoritativeQuantity() const { return Quantity; }
 
 	UFUNCTION(BlueprintCallable, Category = "Item")
-	FORCEINLINE bool IsStackFull() const { return Quantity >= MaxStackSize; }
+	FORCEINLINE bool IsStackFull() const { return GetQuantity() >= MaxStackSize; }
 
 	UFUNCTION(BlueprintPure, BlueprintCallable, Category = "Item")
 	FORCEINLINE URbsInventoryComponent* GetOwningInventory() { return OwningInventory; }
+
+	/**Return the handle of the item in its owning inventory, invalid while the item isn't in one*/
+	UFUNCTION(BlueprintPure, Category = "Item")
+	FORCEINLINE FRbsItemHandle GetItemHandle() const { return Handle; }
 };
@@ -0,0 +1,253 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "Utils/RbsTypes.h"
+#include "RbsInventoryList.generated.h"
+
+class URbsInventoryItem;
+class URbsInventoryComponent;
+class URbsItemDefinition;
+struct FRbsInventoryList;
+struct FRbsItemInstanceList;
+
+/** A single stack stored in an inventory. Only the entries that change are sent over the wire */
+USTRUCT()
+struct REUBSINVENTORYSYSTEM_API FRbsInventoryEntry : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	FRbsInventoryEntry() {};
+	FRbsInventoryEntry(URbsInventoryItem* InItem, const FRbsItemHandle& InHandle, const FRbsGridPlacement& InGridPlacement)
+		: Item(InItem), Handle(InHandle), GridPlacement(InGridPlacement) {};
+
+	UPROPERTY()
+	TObjectPtr<URbsInventoryItem> Item = nullptr;
+
+	//Sent along with the entry so clients can name the stack in RPCs without an object reference
+	UPROPERTY()
+	FRbsItemHandle Handle;
+
+	//Only set in grid inventories
+	UPROPERTY()
+	FRbsGridPlacement GridPlacement;
+
+	//Position of the entry in the list. Spaced out, so moving an entry usually only changes its own order
+	UPROPERTY()
+	int32 Order = 0;
+
+/*
+ * Client callbacks
+ */
+
+	void PreReplicatedRemove(const FRbsInventoryList& InArraySerializer);
+	void PostReplicatedAdd(const FRbsInventoryList& InArraySerializer);
+	void PostReplicatedChange(const FRbsInventoryList& InArraySerializer);
+};
+
+/**
+ * Delta replicated list of inventory stacks.
+ * Entries are always kept in ascending Order, so clients can restore the server order after the fast array swap-removes entries on their side.
+ * Reordering only changes the Order of the entries that moved, the others aren't sent again.
+ */
+USTRUCT()
+struct REUBSINVENTORYSYSTEM_API FRbsInventoryList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	FRbsInventoryList() {};
+	FRbsInventoryList(URbsInventoryComponent* InOwnerComponent) : OwnerComponent(InOwnerComponent) {};
+
+	UPROPERTY()
+	TArray<FRbsInventoryEntry> Entries;
+
+	UPROPERTY(NotReplicated)
+	TObjectPtr<URbsInventoryComponent> OwnerComponent = nullptr;
+
+/*
+ * Behaviour
+ */
+
+	void AddEntry(URbsInventoryItem* Item, const FRbsItemHandle& Handle, const FRbsGridPlacement& GridPlacement = FRbsGridPlacement());
+	bool RemoveEntry(const URbsInventoryItem* Item);
+
+	/**Move the entry at FromIndex to ToIndex. It takes an order between its new neighbours, only when there is none left are the entries in between renumbered*/
+	void MoveEntry(const int32 FromIndex, const int32 ToIndex);
+
+	/**Put the entries in NewOrder, which lists the current index of every entry in its new place. The existing orders are handed out again in the new order*/
+	void ReorderEntries(TConstArrayView<int32> NewOrder);
+
+	//Gap between the orders of entries added one after the other
+	static constexpr int32 OrderStride = 1024;
+
+/*
+ * Replication
+ */
+
+	/**Only written for the connections allowed to see the inventory detail, see URbsInventoryComponent::CanReceiveDetail*/
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+	void PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters);
+
+/*
+ * Helpers
+ */
+
+	FORCEINLINE int32 Num() const { return Entries.Num(); }
+	int32 IndexOf(const URbsInventoryItem* Item) const;
+
+private:
+
+	/**Give the entries from FirstIndex on the orders in SortedOrders, marking dirty only the ones that changed*/
+	void AssignOrders(const int32 FirstIndex, TConstArrayView<int32> SortedOrders);
+};
+
+/** Filter that lets every item through */
+struct FRbsAnyItem
+{
+	FORCEINLINE bool operator()(const URbsInventoryItem* Item) const { return true; }
+};
+
+/**
+ * Non-copying range over the items of an inventory, skipping unresolved entries and the ones rejected by Predicate.
+ * It points straight into the inventory, so don't keep it across changes to it.
+ */
+template<typename PredicateType = FRbsAnyItem>
+class TRbsInventoryItemRange
+{
+public:
+	TRbsInventoryItemRange(TConstArrayView<FRbsInventoryEntry> InEntries, PredicateType InPredicate = PredicateType())
+		: Entries(InEntries), Predicate(MoveTemp(InPredicate)) {};
+
+	class FIterator
+	{
+	public:
+		FIterator(const TRbsInventoryItemRange& InRange, const int32 InIndex) : Range(InRange), Index(InIndex) { SkipFiltered(); }
+
+		FORCEINLINE URbsInventoryItem* operator*() const { return Range.Entries[Index].Item; }
+		FORCEINLINE FIterator& operator++() { ++Index; SkipFiltered(); return *this; }
+		FORCEINLINE bool operator!=(const FIterator& Other) const { return Index != Other.Index; }
+
+	private:
+		void SkipFiltered()
+		{
+			while (Index < Range.Entries.Num() && !(Range.Entries[Index].Item && Invoke(Range.Predicate, Range.Entries[Index].Item.Get())))
+			{
+				++Index;
+			}
+		}
+
+		const TRbsInventoryItemRange& Range;
+		int32 Index;
+	};
+
+	FORCEINLINE FIterator begin() const { return FIterator(*this, 0); }
+	FORCEINLINE FIterator end() const { return FIterator(*this, Entries.Num()); }
+
+private:
+	TConstArrayView<FRbsInventoryEntry> Entries;
+	PredicateType Predicate;
+};
+
+template<>
+struct TStructOpsTypeTraits<FRbsInventoryList> : public TStructOpsTypeTraitsBase2<FRbsInventoryList>
+{
+	enum { WithNetDeltaSerializer = true };
+};
+
+/** A named value only one stack carries, e.g. durability or loaded ammo */
+USTRUCT(BlueprintType)
+struct REUBSINVENTORYSYSTEM_API FRbsItemInstanceValue
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item")
+	FName Name;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item")
+	float Value = 0.f;
+};
+
+/**
+ * A stack of an item definition stored by value. Everything shared by the stacks of an item lives on the definition,
+ * the instance only keeps what differs between them.
+ */
+USTRUCT(BlueprintType)
+struct REUBSINVENTORYSYSTEM_API FRbsItemInstance : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	FRbsItemInstance() {};
+	FRbsItemInstance(const URbsItemDefinition* InDefinition, const int32 InQuantity) : Definition(InDefinition), Quantity(InQuantity) {};
+
+	UPROPERTY(BlueprintReadOnly, Category = "Item")
+	TObjectPtr<const URbsItemDefinition> Definition = nullptr;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Item")
+	int32 Quantity = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Item")
+	TArray<FRbsItemInstanceValue> Payload;
+
+	//What the owning inventory aggregates currently count for this stack, never replicated
+	const URbsItemDefinition* AccountedDefinition = nullptr;
+	int32 AccountedQuantity = 0;
+	bool bCounted = false;
+
+	float GetValue(const FName Name, const float DefaultValue = 0.f) const;
+	void SetValue(const FName Name, const float Value);
+
+/*
+ * Client callbacks
+ */
+
+	void PreReplicatedRemove(const FRbsItemInstanceList& InArraySerializer);
+	void PostReplicatedAdd(const FRbsItemInstanceList& InArraySerializer);
+	void PostReplicatedChange(const FRbsItemInstanceList& InArraySerializer);
+};
+
+/** Delta replicated list of item instances, kept in ReplicationID order, which is the order they were added on the server */
+USTRUCT()
+struct REUBSINVENTORYSYSTEM_API FRbsItemInstanceList : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	FRbsItemInstanceList() {};
+	FRbsItemInstanceList(URbsInventoryComponent* InOwnerComponent) : OwnerComponent(InOwnerComponent) {};
+
+	UPROPERTY()
+	TArray<FRbsItemInstance> Entries;
+
+	UPROPERTY(NotReplicated)
+	TObjectPtr<URbsInventoryComponent> OwnerComponent = nullptr;
+
+/*
+ * Behaviour
+ */
+
+	FRbsItemInstance& AddInstance(const URbsItemDefinition* Definition, const int32 Quantity);
+	void RemoveInstanceAt(const int32 Index);
+
+/*
+ * Replication
+ */
+
+	/**Only written for the connections allowed to see the inventory detail, see URbsInventoryComponent::CanReceiveDetail*/
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+	void PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters);
+
+/*
+ * Helpers
+ */
+
+	FORCEINLINE int32 Num() const { return Entries.Num(); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FRbsItemInstanceList> : public TStructOpsTypeTraitsBase2<FRbsItemInstanceList>
+{
+	enum { WithNetDeltaSerializer = true };
+};
@@ -0,0 +1,73 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "RbsItemDefinition.generated.h"
+
+class URbsItemTooltip;
+
+/**
+ * Static data of an item, shared by every stack of it.
+ * Inventories store stacks of definitions as FRbsItemInstance structs instead of one URbsInventoryItem object per stack.
+ */
+UCLASS(BlueprintType, Const)
+class REUBSINVENTORYSYSTEM_API URbsItemDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsItemDefinition();
+
+///////////////////////////////////////////////////// Variables ////////////////////////////////////////////////////////
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	TSoftClassPtr<AActor> PickupClass;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	TSoftObjectPtr<UTexture2D> Thumbnail;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	FText DisplayName;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	FText Category;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item", meta = (MultiLine = true))
+	FText Description;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item", meta=(InlineEditConditionToggle = true))
+	bool bShowUseText = true;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item", meta=(EditCondition="bShowUseText"))
+	FText UseText;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item", meta = (ClampMin = 0.0))
+	float Weight = 1.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	bool bStackable = true;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item", meta = (ClampMin = 2, EditCondition = bStackable))
+	int32 MaxStackSize = 10;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	TSubclassOf<URbsItemTooltip> ItemTooltip;
+
+	/**Tell players that can't look into the inventory the owner holds this item, through the inventory summary*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item")
+	bool bVisibleInSummary = false;
+
+///////////////////////////////////////////////////// Functions ////////////////////////////////////////////////////////
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	/**Return Thumbnail when it is already loaded. Never loads anything, see URbsInventoryComponent::PrefetchThumbnails*/
+	UFUNCTION(BlueprintPure, Category = "Item")
+	FORCEINLINE UTexture2D* GetThumbnail() const { return Thumbnail.Get(); }
+
+	UFUNCTION(BlueprintPure, Category = "Item")
+	FORCEINLINE int32 GetStackSize() const { return bStackable ? MaxStackSize : 1; }
+};
@@ -0,0 +1,91 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "RbsItemPoolSubsystem.generated.h"
+
+class URbsInventoryItem;
+
+USTRUCT(BlueprintType)
+struct FRbsItemPoolStats
+{
+	GENERATED_BODY()
+
+	//Items handed out from the pool, each one is a NewObject and a later GC of a dead item saved
+	UPROPERTY(BlueprintReadOnly, Category = "Item Pool")
+	int32 Hits = 0;
+
+	//Items that had to be created because the pool had none to give
+	UPROPERTY(BlueprintReadOnly, Category = "Item Pool")
+	int32 Misses = 0;
+
+	//Items given back to the pool
+	UPROPERTY(BlueprintReadOnly, Category = "Item Pool")
+	int32 Recycled = 0;
+
+	//Items left for GC because their pool was already full
+	UPROPERTY(BlueprintReadOnly, Category = "Item Pool")
+	int32 Discarded = 0;
+
+	//Items currently waiting in the pool
+	UPROPERTY(BlueprintReadOnly, Category = "Item Pool")
+	int32 Pooled = 0;
+
+	float GetHitRate() const { return Hits + Misses > 0 ? float(Hits) / float(Hits + Misses) : 0.f; }
+};
+
+/**
+ * Keeps consumed inventory items around so consumables that churn all session (ammo, food...) reuse objects instead of feeding the GC.
+ * Items are pooled per owning actor and class, a pooled item only comes back under the actor it already replicated with,
+ * so clients never see an object move between actor channels.
+ */
+UCLASS(Config = Game)
+class REUBSINVENTORYSYSTEM_API URbsItemPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+/*
+ * Behaviour
+ */
+
+	/**Return a reset item of ItemClass pooled under Outer, or a new one when there is none*/
+	URbsInventoryItem* AcquireItem(TSubclassOf<URbsInventoryItem> ItemClass, UObject* Outer);
+
+	/**Reset Item and keep it for a later AcquireItem. Item must not be in an inventory anymore*/
+	void ReleaseItem(URbsInventoryItem* Item);
+
+	/**Forget every item pooled under Outer so it can be garbage collected*/
+	void ReleaseOuter(const UObject* Outer);
+
+/*
+ * Helpers
+ */
+
+	UFUNCTION(BlueprintPure, Category = "Item Pool")
+	FORCEINLINE FRbsItemPoolStats GetStats() const { return Stats; }
+
+	UFUNCTION(BlueprintPure, Category = "Item Pool")
+	FORCEINLINE float GetHitRate() const { return Stats.GetHitRate(); }
+
+	virtual void Deinitialize() override;
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	//The most idle items kept per actor and class, the rest are left for GC
+	UPROPERTY(Config)
+	int32 MaxPooledPerClass = 32;
+
+private:
+	using FPoolKey = TPair<FObjectKey, const UClass*>;
+
+	TMap<FPoolKey, TArray<TObjectPtr<URbsInventoryItem>>> Pools;
+
+	FRbsItemPoolStats Stats;
+};
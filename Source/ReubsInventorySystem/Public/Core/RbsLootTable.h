@@ -0,0 +1,105 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "Utils/RbsTypes.h"
+#include "RbsLootTable.generated.h"
+
+class URbsInventoryItem;
+class URbsLootTable;
+
+USTRUCT(BlueprintType)
+struct FRbsLootEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot")
+	TSubclassOf<URbsInventoryItem> ItemClass;
+
+	/**Roll this table instead of dropping ItemClass, its drops multiplied by the quantity rolled. With neither set the entry drops nothing*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot")
+	TObjectPtr<URbsLootTable> NestedTable;
+
+	/**Odds of the entry against the other weighted entries of the table, unused by guaranteed entries*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = 0.0))
+	float Weight = 1.f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = 1))
+	int32 MinQuantity = 1;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = 1))
+	int32 MaxQuantity = 1;
+};
+
+/**
+ * What a container may hold: guaranteed entries that always drop, plus a number of weighted picks out of Entries.
+ * Each pick costs the same whatever the number of entries, the table builds an alias sampler of the weights once on load.
+ * Containers only keep a reference to the table and a seed, the items are rolled the first time the container is opened, queried or changed.
+ */
+UCLASS(BlueprintType, Const)
+class REUBSINVENTORYSYSTEM_API URbsLootTable : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+
+///////////////////////////////////////////////////// Variables ////////////////////////////////////////////////////////
+
+	/**Dropped on every roll of the table*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot")
+	TArray<FRbsLootEntry> GuaranteedEntries;
+
+	/**Picked by weight, MinPicks to MaxPicks times per roll of the table*/
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot")
+	TArray<FRbsLootEntry> Entries;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = 0))
+	int32 MinPicks = 1;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Loot", meta = (ClampMin = 0))
+	int32 MaxPicks = 1;
+
+///////////////////////////////////////////////////// Functions ////////////////////////////////////////////////////////
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+
+#endif
+
+	/**Append the items rolled with Stream to OutSpecs, the same seed always rolls the same items*/
+	void RollLoot(FRandomStream& Stream, TArray<FItemSpec>& OutSpecs) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Loot")
+	TArray<FItemSpec> RollLootFromSeed(const int32 Seed) const;
+
+	/**
+	 * Roll Tables[i] with Seeds[i] into OutSpecs[i] for many containers at once, spread across worker threads.
+	 * Every result is the same as rolling the table on its own with that seed.
+	 */
+	static void RollLootBatch(TConstArrayView<const URbsLootTable*> Tables, TConstArrayView<int32> Seeds, TArray<TArray<FItemSpec>>& OutSpecs);
+
+	/**Build the weighted pick sampler of this table and the tables nested in it, must happen on the game thread before rolling from other threads*/
+	void BuildSampler() const;
+
+private:
+
+	struct FRollState;
+
+	/**Roll this table into the specs of State, with every quantity multiplied by Multiplier*/
+	void RollLoot_Internal(FRollState& State, const int32 Depth, const int64 Multiplier) const;
+
+	void RollEntry(const FRbsLootEntry& Entry, FRollState& State, const int32 Depth, const int64 Multiplier) const;
+
+	/**Pick the index of a weighted entry in constant time*/
+	int32 PickEntry(FRandomStream& Stream) const;
+
+	//Vose alias tables, a pick takes one column at random then keeps it or goes to its alias
+	mutable TArray<float> PickProbabilities;
+	mutable TArray<int32> PickAliases;
+
+	mutable bool bSamplerBuilt = false;
+};
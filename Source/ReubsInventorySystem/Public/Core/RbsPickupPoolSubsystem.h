@@ -0,0 +1,71 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RbsPickupPoolSubsystem.generated.h"
+
+/**
+ * Keeps picked up pickups around as dormant actors so dropping items reuses them instead of spawning a new actor every time,
+ * and remembers the latest drops so new ones can be merged into a pickup that was just dropped next to them.
+ * Pickups must implement IRbsPickupInterface, and should call ReleasePickup instead of destroying themselves once picked up.
+ */
+UCLASS(Config = Game)
+class REUBSINVENTORYSYSTEM_API URbsPickupPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+/*
+ * Behaviour
+ */
+
+	/**Return a reactivated pooled pickup of PickupClass moved to SpawnTransform, or spawn a new one when there is none*/
+	AActor* AcquirePickup(UClass* PickupClass, const FTransform& SpawnTransform, AActor* Owner);
+
+	/**Reset Pickup and make it dormant until a later drop of its class, it is destroyed instead when the pool is full*/
+	UFUNCTION(BlueprintCallable, Category = "Pickup Pool")
+	void ReleasePickup(AActor* Pickup);
+
+	/**Remember Pickup was just dropped where it stands*/
+	void RegisterDrop(AActor* Pickup);
+
+	/**Return the latest pickup of PickupClass dropped within Radius of Location in the last TimeWindow seconds*/
+	AActor* FindRecentDrop(const UClass* PickupClass, const FVector& Location, const float Radius, const float TimeWindow);
+
+/*
+ * Helpers
+ */
+
+	UFUNCTION(BlueprintPure, Category = "Pickup Pool")
+	int32 GetPooledCount() const;
+
+	virtual void Deinitialize() override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	//The most dormant pickups kept per class, the rest are destroyed
+	UPROPERTY(Config)
+	int32 MaxPooledPerClass = 16;
+
+	//Drops older than this are forgotten, it should be at least the longest drop coalescing window in use
+	UPROPERTY(Config)
+	float RecentDropLifetime = 5.f;
+
+private:
+	struct FRecentDrop
+	{
+		TWeakObjectPtr<AActor> Pickup;
+		const UClass* PickupClass;
+		FVector Location;
+		double Time;
+	};
+
+	//Actors are kept alive by their level, a pooled pickup destroyed by something else is skipped
+	TMap<const UClass*, TArray<TWeakObjectPtr<AActor>>> Pools;
+
+	TArray<FRecentDrop> RecentDrops;
+};
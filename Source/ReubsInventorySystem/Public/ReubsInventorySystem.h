@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+DECLARE_STATS_GROUP(TEXT("RbsInventory"), STATGROUP_RbsInventory, STATCAT_Advanced);
+
 class FReubsInventorySystemModule : public IModuleInterface
 {
 public:
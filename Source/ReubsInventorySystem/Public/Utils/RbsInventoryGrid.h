@@ -0,0 +1,46 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Occupied cells of a grid inventory, one 64 bit word per row so a whole row is tested with a single mask.
+ * Rects are in cells, Min is inclusive and Max exclusive. Grids are at most 64 cells wide.
+ */
+struct REUBSINVENTORYSYSTEM_API FRbsInventoryGrid
+{
+	static constexpr int32 MaxWidth = 64;
+
+	/**Resize the grid and free every cell*/
+	void Init(const int32 InWidth, const int32 InHeight);
+
+	/**Free every cell, keeping the size*/
+	void Reset();
+
+	/**Whether every cell of Rect is inside the grid and free, cells of Ignored count as free*/
+	bool IsFree(const FIntRect& Rect, const FIntRect& Ignored = FIntRect()) const;
+
+	/**Find the top left most position where Size fits, scanning rows from the top*/
+	bool FindSpace(const FIntPoint& Size, FIntPoint& OutPosition) const;
+
+	void Fill(const FIntRect& Rect);
+	void Clear(const FIntRect& Rect);
+
+	FORCEINLINE int32 GetWidth() const { return Width; }
+	FORCEINLINE int32 GetHeight() const { return Rows.Num(); }
+	FORCEINLINE bool IsInitialized() const { return Width > 0; }
+
+private:
+
+	/**Bits X to X + Count - 1 of a row*/
+	static FORCEINLINE uint64 MakeRowMask(const int32 X, const int32 Count)
+	{
+		return Count >= MaxWidth ? ~uint64(0) : ((uint64(1) << Count) - 1) << X;
+	}
+
+	bool IsInside(const FIntRect& Rect) const;
+
+	TArray<uint64> Rows;
+	int32 Width = 0;
+};
@@ -24,4 +24,16 @@ public:
 
 	UFUNCTION(BlueprintNativeEvent)
 	void OnDropItem();
+
+	/**Return the quantity the pickup holds, or INDEX_NONE when drops shouldn't be merged into it*/
+	UFUNCTION(BlueprintNativeEvent)
+	int32 GetPickupQuantity() const;
+
+	/**Called when the pickup goes back to the pickup pool instead of being destroyed. Hides it and turns its collision off by default*/
+	UFUNCTION(BlueprintNativeEvent)
+	void ResetPickup();
+
+	/**Called when the pickup pool hands the pickup out again, before SetPickupQuantity and OnDropItem. Undoes ResetPickup by default*/
+	UFUNCTION(BlueprintNativeEvent)
+	void ReactivatePickup();
 };
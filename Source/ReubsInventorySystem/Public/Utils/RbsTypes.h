@@ -5,7 +5,9 @@
 #include "CoreMinimal.h"
 #include "RbsTypes.generated.h"
 
+class UPackageMap;
 class URbsInventoryItem;
+class URbsItemDefinition;
 
 UENUM(BlueprintType)
 enum class EItemAddResult : uint8
@@ -15,6 +17,185 @@ enum class EItemAddResult : uint8
 	IAR_AllItemsAdded UMETA(DisplayName = "All items added")
 };
 
+UENUM(BlueprintType)
+enum class ERbsItemSortKey : uint8
+{
+	//Alphabetical by class name
+	Class,
+	//Alphabetical by category, then by class
+	Category,
+	//Heaviest stacks first
+	Weight,
+	//Largest stacks first
+	Quantity
+};
+
+/**
+ * Compact reference to a single stack of an inventory: a slot index plus the generation of that slot.
+ * A slot is reused once its stack leaves, bumping the generation, so an old handle never resolves to the next stack.
+ */
+USTRUCT(BlueprintType)
+struct REUBSINVENTORYSYSTEM_API FRbsItemHandle
+{
+	GENERATED_BODY()
+
+	FRbsItemHandle() {};
+	FRbsItemHandle(const int32 InIndex, const int32 InGeneration) : Index(InIndex), Generation(InGeneration) {};
+
+	UPROPERTY()
+	int32 Index = INDEX_NONE;
+
+	UPROPERTY()
+	int32 Generation = 0;
+
+	FORCEINLINE bool IsValid() const { return Index != INDEX_NONE; }
+
+	FORCEINLINE bool operator==(const FRbsItemHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+	FORCEINLINE bool operator!=(const FRbsItemHandle& Other) const { return !(*this == Other); }
+	friend FORCEINLINE uint32 GetTypeHash(const FRbsItemHandle& Handle) { return HashCombine(GetTypeHash(Handle.Index), GetTypeHash(Handle.Generation)); }
+
+	/**Both numbers are written packed, a handle usually takes 2 bytes on the wire*/
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FRbsItemHandle> : public TStructOpsTypeTraitsBase2<FRbsItemHandle>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
+/** Where a stack sits in a grid inventory: the cell of its top left corner, and whether it is turned sideways */
+USTRUCT(BlueprintType)
+struct REUBSINVENTORYSYSTEM_API FRbsGridPlacement
+{
+	GENERATED_BODY()
+
+	FRbsGridPlacement() {};
+	FRbsGridPlacement(const int32 InX, const int32 InY, const bool bInRotated) : X(InX), Y(InY), bRotated(bInRotated) {};
+
+	UPROPERTY(BlueprintReadOnly, Category = "Grid")
+	int32 X = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Grid")
+	int32 Y = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Grid")
+	bool bRotated = false;
+
+	FORCEINLINE bool IsValid() const { return X != INDEX_NONE && Y != INDEX_NONE; }
+
+	/**Cells covered by a Width x Height item placed here*/
+	FORCEINLINE FIntRect GetRect(const int32 Width, const int32 Height) const
+	{
+		return IsValid() ? FIntRect(X, Y, X + (bRotated ? Height : Width), Y + (bRotated ? Width : Height)) : FIntRect();
+	}
+
+	FORCEINLINE bool operator==(const FRbsGridPlacement& Other) const { return X == Other.X && Y == Other.Y && bRotated == Other.bRotated; }
+	FORCEINLINE bool operator!=(const FRbsGridPlacement& Other) const { return !(*this == Other); }
+
+	/**A placed stack takes 6 bits of column, a packed row and the rotation bit, an unplaced one a single bit*/
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FRbsGridPlacement> : public TStructOpsTypeTraitsBase2<FRbsGridPlacement>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true
+	};
+};
+
+UENUM()
+enum class ERbsInventoryCommandType : uint8
+{
+	Use,
+	Drop,
+	Split,
+	Move
+};
+
+/** An inventory action an owning client asks the server for, sent in batches once per frame */
+USTRUCT()
+struct REUBSINVENTORYSYSTEM_API FRbsInventoryCommand
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint16 Sequence = 0;
+
+	UPROPERTY()
+	ERbsInventoryCommandType Type = ERbsInventoryCommandType::Use;
+
+	UPROPERTY()
+	FRbsItemHandle Handle;
+
+	//Amount to drop or split off
+	UPROPERTY()
+	int32 Quantity = 0;
+
+	//Where a moved item goes in the item order
+	UPROPERTY()
+	int32 TargetIndex = INDEX_NONE;
+
+	/**Sequences wrap around, A is newer than B when it is less than half the range ahead*/
+	static FORCEINLINE bool IsSequenceNewer(const uint16 A, const uint16 B) { return static_cast<int16>(A - B) > 0; }
+
+	/**Only writes the fields the command type uses*/
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FRbsInventoryCommand> : public TStructOpsTypeTraitsBase2<FRbsInventoryCommand>
+{
+	enum { WithNetSerializer = true };
+};
+
+/** What other players get to know about an inventory they can't look into */
+USTRUCT(BlueprintType)
+struct FRbsInventorySummary
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory Summary")
+	float TotalWeight = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory Summary")
+	int32 StackCount = 0;
+
+	//Item classes held that show on the owner, e.g. a weapon on the back
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory Summary")
+	TArray<TSubclassOf<URbsInventoryItem>> VisibleItemClasses;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Inventory Summary")
+	TArray<TObjectPtr<const URbsItemDefinition>> VisibleDefinitions;
+
+	bool operator==(const FRbsInventorySummary& Other) const
+	{
+		return TotalWeight == Other.TotalWeight && StackCount == Other.StackCount && VisibleItemClasses == Other.VisibleItemClasses && VisibleDefinitions == Other.VisibleDefinitions;
+	}
+};
+
+USTRUCT(BlueprintType)
+struct FItemSpec
+{
+	GENERATED_BODY()
+
+	FItemSpec() {};
+	FItemSpec(TSubclassOf<URbsInventoryItem> InItemClass, int32 InQuantity) : ItemClass(InItemClass), Quantity(InQuantity) {};
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Spec")
+	TSubclassOf<URbsInventoryItem> ItemClass;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Spec", meta = (ClampMin = 1))
+	int32 Quantity = 1;
+};
+
 USTRUCT(BlueprintType)
 struct FItemAddResult
 {
@@ -71,4 +252,15 @@ struct FItemAddResult
 
 		return AddAllResult;
 	}
-};
\ No newline at end of file
+};
+
+/** Quantities of item classes needed together, e.g. the ingredients of a recipe */
+USTRUCT(BlueprintType)
+struct FRbsItemRequirements
+{
+	GENERATED_BODY()
+
+	//Counted by exact class, child classes don't count towards their parent
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Item Requirements")
+	TMap<TSubclassOf<URbsInventoryItem>, int32> Items;
+};
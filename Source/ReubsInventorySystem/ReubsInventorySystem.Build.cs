@@ -7,6 +7,10 @@ public class ReubsInventorySystem : ModuleRules
 	public ReubsInventorySystem(ReadOnlyTargetRules Target) : base(Target)
 	{
 		PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		// Replicated inventory properties are push based, set to false to fall back to classic property polling
+		bool bUsePushModel = true;
+		PublicDefinitions.Add("RBS_WITH_PUSH_MODEL=" + (bUsePushModel ? "1" : "0"));
 		
 		PublicIncludePaths.AddRange(
 			new string[] {
@@ -26,6 +30,7 @@ public class ReubsInventorySystem : ModuleRules
 			new string[]
 			{
 				"Core",
+				"NetCore",
 				"UMG"
 				// ... add other public dependencies that you statically link with here ...
 			}
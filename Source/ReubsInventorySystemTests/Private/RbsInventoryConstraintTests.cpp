@@ -0,0 +1,295 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "RbsInventoryTestTypes.h"
+
+namespace RbsInventoryConstraintTests
+{
+	const URbsInventoryItem* GetDefaults(const TSubclassOf<URbsInventoryItem> ItemClass)
+	{
+		return ItemClass->GetDefaultObject<URbsInventoryItem>();
+	}
+
+	/**A game world with a single actor owning an inventory, destroyed when this goes out of scope*/
+	struct FTestInventory
+	{
+		explicit FTestInventory(const TArray<URbsInventoryConstraint*>& InConstraints)
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false);
+			GEngine->CreateNewWorldContext(EWorldType::Game).SetCurrentWorld(World);
+
+			AActor* Owner = World->SpawnActor<AActor>();
+			Inventory = NewObject<URbsTestInventoryComponent>(Owner);
+			for (URbsInventoryConstraint* Constraint : InConstraints)
+			{
+				Inventory->AddConstraint(Constraint);
+			}
+			Inventory->RegisterComponent();
+		}
+
+		~FTestInventory()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+		}
+
+		UWorld* World = nullptr;
+		URbsTestInventoryComponent* Inventory = nullptr;
+	};
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRbsWeightConstraintTest, "ReubsInventory.Constraints.Weight", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRbsWeightConstraintTest::RunTest(const FString& Parameters)
+{
+	URbsWeightConstraint* Constraint = NewObject<URbsWeightConstraint>();
+	Constraint->MaxWeight = 10.f;
+
+	const URbsInventoryItem* Food = RbsInventoryConstraintTests::GetDefaults(URbsTestFoodItem::StaticClass());
+	const URbsInventoryItem* Medkit = RbsInventoryConstraintTests::GetDefaults(URbsTestMedkitItem::StaticClass());
+
+	TestEqual(TEXT("Empty"), Constraint->GetMaxAddable(Food), 10);
+
+	Constraint->AddQuantity(Food, 4);
+	TestEqual(TEXT("Same item after adding"), Constraint->GetMaxAddable(Food), 6);
+	TestEqual(TEXT("Heavier item after adding"), Constraint->GetMaxAddable(Medkit), 3);
+
+	Constraint->AddQuantity(Medkit, 3);
+	TestEqual(TEXT("Full"), Constraint->GetMaxAddable(Food), 0);
+
+	Constraint->AddQuantity(Food, -4);
+	TestEqual(TEXT("After removing"), Constraint->GetMaxAddable(Food), 4);
+
+	Constraint->ResetAggregates();
+	TestEqual(TEXT("After reset"), Constraint->GetMaxAddable(Medkit), 5);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRbsVolumeConstraintTest, "ReubsInventory.Constraints.Volume", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRbsVolumeConstraintTest::RunTest(const FString& Parameters)
+{
+	URbsVolumeConstraint* Constraint = NewObject<URbsVolumeConstraint>();
+	Constraint->MaxVolume = 20.f;
+
+	const URbsInventoryItem* Food = RbsInventoryConstraintTests::GetDefaults(URbsTestFoodItem::StaticClass());
+	const URbsInventoryItem* Medkit = RbsInventoryConstraintTests::GetDefaults(URbsTestMedkitItem::StaticClass());
+
+	TestEqual(TEXT("Empty"), Constraint->GetMaxAddable(Food), 10);
+	TestEqual(TEXT("Items without volume aren't limited"), Constraint->GetMaxAddable(RbsInventoryConstraintTests::GetDefaults(URbsInventoryItem::StaticClass())), MAX_int32);
+
+	Constraint->AddQuantity(Medkit, 2);
+	TestEqual(TEXT("After adding"), Constraint->GetMaxAddable(Food), 5);
+	TestEqual(TEXT("Bigger item after adding"), Constraint->GetMaxAddable(Medkit), 2);
+
+	Constraint->AddQuantity(Medkit, -1);
+	TestEqual(TEXT("After removing"), Constraint->GetMaxAddable(Medkit), 3);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRbsCategoryConstraintTest, "ReubsInventory.Constraints.Category", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRbsCategoryConstraintTest::RunTest(const FString& Parameters)
+{
+	URbsCategoryConstraint* Constraint = NewObject<URbsCategoryConstraint>();
+	FRbsCategoryLimit& Limit = Constraint->Limits.AddDefaulted_GetRef();
+	Limit.Category = INVTEXT("Medical");
+	Limit.MaxQuantity = 3;
+	Constraint->ResetAggregates();
+
+	const URbsInventoryItem* Food = RbsInventoryConstraintTests::GetDefaults(URbsTestFoodItem::StaticClass());
+	const URbsInventoryItem* Medkit = RbsInventoryConstraintTests::GetDefaults(URbsTestMedkitItem::StaticClass());
+	const URbsInventoryItem* LargeMedkit = RbsInventoryConstraintTests::GetDefaults(URbsTestLargeMedkitItem::StaticClass());
+
+	TestEqual(TEXT("Limited category"), Constraint->GetMaxAddable(Medkit), 3);
+	TestEqual(TEXT("Other category"), Constraint->GetMaxAddable(Food), MAX_int32);
+
+	Constraint->AddQuantity(Medkit, 2);
+	TestEqual(TEXT("Same category, other class"), Constraint->GetMaxAddable(LargeMedkit), 1);
+
+	Constraint->AddQuantity(LargeMedkit, 1);
+	TestEqual(TEXT("Full"), Constraint->GetMaxAddable(Medkit), 0);
+	TestEqual(TEXT("Other category when full"), Constraint->GetMaxAddable(Food), MAX_int32);
+
+	Constraint->AddQuantity(Medkit, -2);
+	TestEqual(TEXT("After removing"), Constraint->GetMaxAddable(Medkit), 2);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRbsClassConstraintTest, "ReubsInventory.Constraints.Class", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRbsClassConstraintTest::RunTest(const FString& Parameters)
+{
+	URbsClassConstraint* Constraint = NewObject<URbsClassConstraint>();
+	FRbsClassLimit& MedkitLimit = Constraint->Limits.AddDefaulted_GetRef();
+	MedkitLimit.ItemClass = URbsTestMedkitItem::StaticClass();
+	MedkitLimit.MaxQuantity = 4;
+	FRbsClassLimit& LargeMedkitLimit = Constraint->Limits.AddDefaulted_GetRef();
+	LargeMedkitLimit.ItemClass = URbsTestLargeMedkitItem::StaticClass();
+	LargeMedkitLimit.MaxQuantity = 1;
+	Constraint->ResetAggregates();
+
+	const URbsInventoryItem* Food = RbsInventoryConstraintTests::GetDefaults(URbsTestFoodItem::StaticClass());
+	const URbsInventoryItem* Medkit = RbsInventoryConstraintTests::GetDefaults(URbsTestMedkitItem::StaticClass());
+	const URbsInventoryItem* LargeMedkit = RbsInventoryConstraintTests::GetDefaults(URbsTestLargeMedkitItem::StaticClass());
+
+	TestEqual(TEXT("Limited class"), Constraint->GetMaxAddable(Medkit), 4);
+	TestEqual(TEXT("Child class takes the tightest limit"), Constraint->GetMaxAddable(LargeMedkit), 1);
+	TestEqual(TEXT("Unlimited class"), Constraint->GetMaxAddable(Food), MAX_int32);
+
+	Constraint->AddQuantity(LargeMedkit, 1);
+	TestEqual(TEXT("Child class counts towards its parent's limit"), Constraint->GetMaxAddable(Medkit), 3);
+	TestEqual(TEXT("Child class full"), Constraint->GetMaxAddable(LargeMedkit), 0);
+
+	Constraint->AddQuantity(Medkit, 3);
+	TestEqual(TEXT("Parent class full"), Constraint->GetMaxAddable(Medkit), 0);
+
+	Constraint->AddQuantity(LargeMedkit, -1);
+	TestEqual(TEXT("After removing"), Constraint->GetMaxAddable(Medkit), 1);
+	TestEqual(TEXT("Child class after removing"), Constraint->GetMaxAddable(LargeMedkit), 1);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRbsConstraintHeadroomTest, "ReubsInventory.Constraints.Headroom", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRbsConstraintHeadroomTest::RunTest(const FString& Parameters)
+{
+	URbsClassConstraint* Constraint = NewObject<URbsClassConstraint>();
+	FRbsClassLimit& Limit = Constraint->Limits.AddDefaulted_GetRef();
+	Limit.ItemClass = URbsTestMedkitItem::StaticClass();
+	Limit.MaxQuantity = 4;
+	Constraint->ResetAggregates();
+
+	const URbsInventoryItem* Medkit = RbsInventoryConstraintTests::GetDefaults(URbsTestMedkitItem::StaticClass());
+	Constraint->AddQuantity(Medkit, 1);
+
+	TArray<double> Headroom;
+	Constraint->GetHeadroom(Headroom);
+	TestEqual(TEXT("Headroom starts at the live totals"), Constraint->GetMaxAddable(Medkit, Headroom), 3);
+
+	Constraint->SpendHeadroom(Medkit, 2, Headroom);
+	TestEqual(TEXT("Spent headroom"), Constraint->GetMaxAddable(Medkit, Headroom), 1);
+	TestEqual(TEXT("Spending headroom leaves the live totals alone"), Constraint->GetMaxAddable(Medkit), 3);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRbsInventoryConstraintsTest, "ReubsInventory.Constraints.Inventory", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRbsInventoryConstraintsTest::RunTest(const FString& Parameters)
+{
+	URbsWeightConstraint* WeightConstraint = NewObject<URbsWeightConstraint>();
+	WeightConstraint->MaxWeight = 20.f;
+
+	URbsCategoryConstraint* CategoryConstraint = NewObject<URbsCategoryConstraint>();
+	FRbsCategoryLimit& Limit = CategoryConstraint->Limits.AddDefaulted_GetRef();
+	Limit.Category = INVTEXT("Medical");
+	Limit.MaxQuantity = 3;
+
+	const RbsInventoryConstraintTests::FTestInventory Test({ WeightConstraint, CategoryConstraint });
+	URbsTestInventoryComponent* Inventory = Test.Inventory;
+
+	TestEqual(TEXT("Tightest constraint wins"), Inventory->GetMaxAddableQuantity(URbsTestMedkitItem::StaticClass()), 3);
+	TestEqual(TEXT("Only the constraints that limit the item count"), Inventory->GetMaxAddableQuantity(URbsTestFoodItem::StaticClass()), 20);
+
+	const FItemAddResult Added = Inventory->TryAddItemFromClass(URbsTestMedkitItem::StaticClass(), 2);
+	URbsInventoryItem* Medkits = Added.AddedItem;
+	if (!TestNotNull(TEXT("Added stack"), Medkits))
+		return false;
+
+	TestEqual(TEXT("Category after adding"), Inventory->GetMaxAddableQuantity(URbsTestMedkitItem::StaticClass()), 1);
+	TestEqual(TEXT("Weight after adding"), Inventory->GetMaxAddableQuantity(URbsTestFoodItem::StaticClass()), 16);
+
+	Medkits->SetQuantity(1);
+	TestEqual(TEXT("Category after a quantity change"), Inventory->GetMaxAddableQuantity(URbsTestMedkitItem::StaticClass()), 2);
+	TestEqual(TEXT("Weight after a quantity change"), Inventory->GetMaxAddableQuantity(URbsTestFoodItem::StaticClass()), 18);
+
+	Inventory->RemoveItem(Medkits);
+	TestEqual(TEXT("Category after removing"), Inventory->GetMaxAddableQuantity(URbsTestMedkitItem::StaticClass()), 3);
+	TestEqual(TEXT("Weight after removing"), Inventory->GetMaxAddableQuantity(URbsTestFoodItem::StaticClass()), 20);
+
+	//Later specs of a batch see what the earlier ones take
+	const TArray<FItemAddResult> Results = Inventory->TryAddItems({ FItemSpec(URbsTestMedkitItem::StaticClass(), 5), FItemSpec(URbsTestFoodItem::StaticClass(), 30) });
+	TestEqual(TEXT("Batch limited by category"), Results[0].AmountGiven, 3);
+	TestEqual(TEXT("Batch limited by the weight left"), Results[1].AmountGiven, 14);
+	TestEqual(TEXT("Batch added what it planned"), Inventory->GetTotalQuantity(URbsTestFoodItem::StaticClass()), 14);
+	TestEqual(TEXT("Weight after the batch"), Inventory->GetMaxAddableQuantity(URbsTestFoodItem::StaticClass()), 0);
+	TestEqual(TEXT("Category after the batch"), Inventory->GetMaxAddableQuantity(URbsTestMedkitItem::StaticClass()), 0);
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRbsConstraintAddCostTest, "ReubsInventory.Constraints.AddCost", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRbsConstraintAddCostTest::RunTest(const FString& Parameters)
+{
+	constexpr float MaxWeight = 100000.f;
+	const int32 FoodStackSize = RbsInventoryConstraintTests::GetDefaults(URbsTestFoodItem::StaticClass())->MaxStackSize;
+
+	struct FAddCost
+	{
+		int32 MaxAddable = 0;
+		int32 AmountGiven = 0;
+		int32 Evaluations = 0;
+		int32 Updates = 0;
+		int64 CountedQuantity = 0;
+	};
+
+	//Fill an inventory with FillerStacks full stacks of food, then ask for and add 3 medkits
+	auto MeasureAdd = [this, MaxWeight, FoodStackSize](const int32 FillerStacks)
+	{
+		URbsTestCountingConstraint* Counter = NewObject<URbsTestCountingConstraint>();
+		URbsWeightConstraint* WeightConstraint = NewObject<URbsWeightConstraint>();
+		WeightConstraint->MaxWeight = MaxWeight;
+
+		const RbsInventoryConstraintTests::FTestInventory Test({ Counter, WeightConstraint });
+		URbsTestInventoryComponent* Inventory = Test.Inventory;
+		Inventory->SetCapacity(FillerStacks + 1);
+		Inventory->SetWeightCapacity(MaxWeight);
+
+		Inventory->TryAddItemFromClass(URbsTestFoodItem::StaticClass(), FillerStacks * FoodStackSize);
+		TestEqual(TEXT("Filler stacks"), Inventory->GetStackCount(), FillerStacks);
+
+		Counter->ResetCounts();
+
+		FAddCost Cost;
+		Cost.MaxAddable = Inventory->GetMaxAddableQuantity(URbsTestMedkitItem::StaticClass());
+		Cost.AmountGiven = Inventory->TryAddItemFromClass(URbsTestMedkitItem::StaticClass(), 3).AmountGiven;
+		Cost.Evaluations = Counter->Evaluations;
+		Cost.Updates = Counter->Updates;
+		Cost.CountedQuantity = Counter->Quantity;
+		return Cost;
+	};
+
+	const FAddCost Few = MeasureAdd(3);
+	const FAddCost Many = MeasureAdd(500);
+
+	//Medkits weigh 2 and food 1
+	TestEqual(TEXT("Max addable with few stacks"), Few.MaxAddable, static_cast<int32>((MaxWeight - 3 * FoodStackSize) / 2));
+	TestEqual(TEXT("Max addable with many stacks"), Many.MaxAddable, static_cast<int32>((MaxWeight - 500 * FoodStackSize) / 2));
+	TestEqual(TEXT("Added with few stacks"), Few.AmountGiven, 3);
+	TestEqual(TEXT("Added with many stacks"), Many.AmountGiven, 3);
+
+	//The constraints are asked and told the same number of times whatever the inventory holds, so nothing walks the stacks
+	TestEqual(TEXT("Constraint evaluations don't grow with the stacks"), Many.Evaluations, Few.Evaluations);
+	TestEqual(TEXT("Constraint updates don't grow with the stacks"), Many.Updates, Few.Updates);
+	TestEqual(TEXT("A single update for the new stack"), Many.Updates, 1);
+
+	//The running total was updated with the medkits, not recounted
+	TestEqual(TEXT("Running total with few stacks"), Few.CountedQuantity, static_cast<int64>(3 * FoodStackSize + 3));
+	TestEqual(TEXT("Running total with many stacks"), Many.CountedQuantity, static_cast<int64>(500 * FoodStackSize + 3));
+
+	return true;
+}
+
+#endif
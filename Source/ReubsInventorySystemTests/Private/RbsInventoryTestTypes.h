@@ -0,0 +1,97 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/RbsInventoryComponent.h"
+#include "Core/RbsInventoryConstraint.h"
+#include "Core/RbsInventoryItem.h"
+#include "RbsInventoryTestTypes.generated.h"
+
+/*
+ * Only used by the automation tests of this module
+ */
+
+UCLASS(NotBlueprintable, HideDropdown)
+class URbsTestFoodItem : public URbsInventoryItem
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsTestFoodItem()
+	{
+		Category = INVTEXT("Food");
+		Weight = 1.f;
+		Volume = 2.f;
+		MaxStackSize = 10;
+	}
+};
+
+UCLASS(NotBlueprintable, HideDropdown)
+class URbsTestMedkitItem : public URbsInventoryItem
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsTestMedkitItem()
+	{
+		Category = INVTEXT("Medical");
+		Weight = 2.f;
+		Volume = 5.f;
+		MaxStackSize = 5;
+	}
+};
+
+UCLASS(NotBlueprintable, HideDropdown)
+class URbsTestLargeMedkitItem : public URbsTestMedkitItem
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsTestLargeMedkitItem()
+	{
+		Weight = 4.f;
+	}
+};
+
+/** Limits nothing, counts how often the inventory asks and tells it about quantities */
+UCLASS(NotBlueprintable, HideDropdown)
+class URbsTestCountingConstraint : public URbsInventoryConstraint
+{
+	GENERATED_BODY()
+
+public:
+
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item) const override { Evaluations++; return MAX_int32; }
+	virtual int32 GetMaxAddable(const URbsInventoryItem* Item, TConstArrayView<double> Headroom) const override { Evaluations++; return MAX_int32; }
+	virtual void AddQuantity(const URbsInventoryItem* Item, const int32 Delta) override { Updates++; Quantity += Delta; }
+	virtual void ResetAggregates() override { Quantity = 0; }
+
+	void ResetCounts() { Evaluations = 0; Updates = 0; }
+
+	mutable int32 Evaluations = 0;
+	int32 Updates = 0;
+
+	//Running total of every quantity it was told about
+	int64 Quantity = 0;
+};
+
+UCLASS(NotBlueprintable, HideDropdown)
+class URbsTestInventoryComponent : public URbsInventoryComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	URbsTestInventoryComponent()
+	{
+		Capacity = 20;
+		WeightCapacity = 1000.f;
+	}
+
+	/**Must happen before the component is registered, the constraint totals are only built on register*/
+	void AddConstraint(URbsInventoryConstraint* Constraint) { Constraints.Add(Constraint); }
+};
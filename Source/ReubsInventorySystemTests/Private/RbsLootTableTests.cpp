@@ -0,0 +1,74 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Core/RbsLootTable.h"
+#include "RbsInventoryTestTypes.h"
+
+namespace RbsLootTableTests
+{
+	FRbsLootEntry MakeEntry(const TSubclassOf<URbsInventoryItem> ItemClass, URbsLootTable* NestedTable, const float Weight, const int32 MinQuantity, const int32 MaxQuantity)
+	{
+		FRbsLootEntry Entry;
+		Entry.ItemClass = ItemClass;
+		Entry.NestedTable = NestedTable;
+		Entry.Weight = Weight;
+		Entry.MinQuantity = MinQuantity;
+		Entry.MaxQuantity = MaxQuantity;
+		return Entry;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FRbsLootTableBatchTest, "ReubsInventory.LootTable.Batch", EAutomationTestFlags::EditorContext | EAutomationTestFlags::EngineFilter)
+
+bool FRbsLootTableBatchTest::RunTest(const FString& Parameters)
+{
+	URbsLootTable* Inner = NewObject<URbsLootTable>();
+	Inner->Entries.Add(RbsLootTableTests::MakeEntry(URbsTestFoodItem::StaticClass(), nullptr, 1.f, 1, 3));
+	Inner->Entries.Add(RbsLootTableTests::MakeEntry(URbsTestMedkitItem::StaticClass(), nullptr, 2.f, 1, 2));
+
+	URbsLootTable* Outer = NewObject<URbsLootTable>();
+	Outer->GuaranteedEntries.Add(RbsLootTableTests::MakeEntry(URbsTestFoodItem::StaticClass(), nullptr, 1.f, 1, 1));
+	Outer->Entries.Add(RbsLootTableTests::MakeEntry(nullptr, Inner, 1.f, 1, 2));
+	Outer->Entries.Add(RbsLootTableTests::MakeEntry(URbsTestLargeMedkitItem::StaticClass(), nullptr, 3.f, 1, 1));
+	Outer->MinPicks = 2;
+	Outer->MaxPicks = 4;
+
+	//A null table rolls nothing
+	TArray<const URbsLootTable*> Tables;
+	TArray<int32> Seeds;
+	for (int32 Index = 0; Index < 64; Index++)
+	{
+		Tables.Add(Index % 8 == 7 ? nullptr : Index % 2 == 0 ? Outer : Inner);
+		Seeds.Add(Index * 7919 + 1);
+	}
+
+	TArray<TArray<FItemSpec>> BatchSpecs;
+	URbsLootTable::RollLootBatch(Tables, Seeds, BatchSpecs);
+	if (!TestEqual(TEXT("One result per table"), BatchSpecs.Num(), Tables.Num()))
+		return false;
+
+	int32 RolledSpecs = 0;
+	for (int32 Index = 0; Index < Tables.Num(); Index++)
+	{
+		const TArray<FItemSpec> Specs = Tables[Index] ? Tables[Index]->RollLootFromSeed(Seeds[Index]) : TArray<FItemSpec>();
+		const FString What = FString::Printf(TEXT("Table %d"), Index);
+		if (!TestEqual(What + TEXT(" spec count"), BatchSpecs[Index].Num(), Specs.Num()))
+			continue;
+
+		for (int32 SpecIndex = 0; SpecIndex < Specs.Num(); SpecIndex++)
+		{
+			TestTrue(What + TEXT(" spec class"), BatchSpecs[Index][SpecIndex].ItemClass == Specs[SpecIndex].ItemClass);
+			TestEqual(What + TEXT(" spec quantity"), BatchSpecs[Index][SpecIndex].Quantity, Specs[SpecIndex].Quantity);
+		}
+		RolledSpecs += Specs.Num();
+	}
+
+	TestTrue(TEXT("Something was rolled"), RolledSpecs > 0);
+
+	return true;
+}
+
+#endif
@@ -0,0 +1,5 @@
+﻿// Copyright Vinipi Studios 2024. All Rights Reserved.
+
+#include "Modules/ModuleManager.h"
+
+IMPLEMENT_MODULE(FDefaultModuleImpl, ReubsInventorySystemTests)